@@ -89,8 +89,9 @@ int main(int argc, char const *argv[]) {
     return 1;
   }
 
-  HepMC3::GenEvent evt;
-  rdr->read_event(evt);
+  // NuHepMC::Reader reads the first event on construction, so the GenRunInfo
+  // is available straight away and the first event will be handed back by
+  // the first call to read_event.
   if (rdr->failed()) {
     std::cout << "Failed to read the first event from " << inf << std::endl;
     return 1;
@@ -112,11 +113,10 @@ int main(int argc, char const *argv[]) {
   vtxstatus = GR9::ReadVertexStatusIdDefinitions(run_info);
   partstatus = GR10::ReadParticleStatusIdDefinitions(run_info);
 
-  // determine the units scale
-  ToGeV = Event::ToMeVFactor(evt) * 1E-3;
+  // determine the units scale from the first event
+  ToGeV = Event::ToMeVFactor(rdr->momentum_unit()) * 1E-3;
 
-  // re-open the file to start from the first event
-  rdr = std::make_unique<NuHepMC::Reader>(inf);
+  HepMC3::GenEvent evt;
   while (true) {
 
     // read an event and check that you haven't finished the file.
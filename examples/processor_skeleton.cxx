@@ -3,12 +3,11 @@
 #include "NuHepMC/HepMC3Features.hxx"
 
 #include "NuHepMC/EventUtils.hxx"
+#include "NuHepMC/Reader.hxx"
 #include "NuHepMC/ReaderUtils.hxx"
 #include "NuHepMC/WriterUtils.hxx"
 #include "NuHepMC/make_writer.hxx"
 
-#include "HepMC3/ReaderFactory.h"
-
 #include "HepMC3/GenEvent.h"
 #include "HepMC3/GenParticle.h"
 #include "HepMC3/GenVertex.h"
@@ -24,25 +23,19 @@ auto GetPartFromId(HepMC3::GenEvent &evt, int id) {
 
 int main(int argc, char const *argv[]) {
 
-  auto rdr = HepMC3::deduce_reader(argv[1]);
-  if (!rdr) {
-    std::cout << "Failed to instantiate HepMC3::Reader from " << argv[1]
-              << std::endl;
-    return 1;
-  }
+  auto rdr = std::make_unique<NuHepMC::Reader>(argv[1]);
 
-  // for files that you know can be opened multiple times without failing (i.e.
-  // not a stream) it is easiest to read one event, and grab the
-  // HepMC3::GenRunInfo here.
-  HepMC3::GenEvent evt;
-  rdr->read_event(evt);
+  // NuHepMC::Reader reads the first event on construction, so the
+  // HepMC3::GenRunInfo is available straight away, and the first event will be
+  // handed back by the first call to read_event. This also works for streams
+  // that cannot be re-opened.
   if (rdr->failed()) {
-    std::cout << "Failed to read first event from " << argv[1] << "."
+    std::cerr << "Failed to read first event from " << argv[1] << "."
               << std::endl;
     return 1;
   }
 
-  auto in_gen_run_info = evt.run_info();
+  auto in_gen_run_info = rdr->run_info();
   auto vtx_statuses =
       NuHepMC::GR9::ReadVertexStatusIdDefinitions(in_gen_run_info);
   auto part_statuses =
@@ -74,17 +67,20 @@ int main(int argc, char const *argv[]) {
                                          "2404.12345v3",
                                      });
 
+  // serialise and compress output on a background thread so that it overlaps
+  // with the processing of the next event
+  NuHepMC::Writer::WriterOptions wopts;
+  wopts.async = true;
   auto wrtr = std::unique_ptr<HepMC3::Writer>(
-      NuHepMC::Writer::make_writer(argv[2], out_gen_run_info));
+      NuHepMC::Writer::make_writer(argv[2], out_gen_run_info, wopts));
 
-  // re-open the file so that you start at the beginning
-  rdr = HepMC3::deduce_reader(argv[1]);
+  HepMC3::GenEvent evt;
   size_t nprocessed = 0;
   while (true) { // loop while there are events
 
     rdr->read_event(evt);
     if (rdr->failed()) {
-      std::cout << "Reached the end of the file after " << nprocessed
+      std::cerr << "Reached the end of the file after " << nprocessed
                 << " events." << std::endl;
       break;
     }
@@ -11,6 +11,7 @@
 #include "pybind11/stl_bind.h"
 
 #include <string>
+#include <vector>
 
 namespace py = pybind11;
 using namespace NuHepMC;
@@ -56,21 +57,60 @@ PYBIND11_MODULE(pyNuHepMC, m) {
   particle_number.attr("NuclearRemnant") = ParticleNumber::NuclearRemnant;
 
   auto event_utils = m.def_submodule("EventUtils", "");
-  event_utils.def("GetVertex_First", &Event::GetVertex_First, "");
-  event_utils.def("GetPrimaryVertex", &Event::GetPrimaryVertex, "");
-  event_utils.def("GetBeamParticle", &Event::GetBeamParticle, "");
-  event_utils.def("GetTargetParticle", &Event::GetTargetParticle, "");
-  event_utils.def("GetParticles_All", &Event::GetParticles_All, "");
+  // the EventUtils functions are also overloaded for Event::Index, only the
+  // HepMC3::GenEvent versions are bound
+  using PDGList = std::vector<int>;
+  event_utils.def("GetVertex_First",
+                  py::overload_cast<HepMC3::GenEvent const &, int>(
+                      &Event::GetVertex_First),
+                  "");
+  event_utils.def(
+      "GetPrimaryVertex",
+      py::overload_cast<HepMC3::GenEvent const &>(&Event::GetPrimaryVertex),
+      "");
+  event_utils.def(
+      "GetBeamParticle",
+      py::overload_cast<HepMC3::GenEvent const &>(&Event::GetBeamParticle),
+      "");
+  event_utils.def(
+      "GetTargetParticle",
+      py::overload_cast<HepMC3::GenEvent const &>(&Event::GetTargetParticle),
+      "");
+  event_utils.def(
+      "GetParticles_All",
+      py::overload_cast<HepMC3::GenEvent const &, int, PDGList const &>(
+          &Event::GetParticles_All),
+      "");
   event_utils.def("GetParticles_AllRealFinalState",
-                  &Event::GetParticles_AllRealFinalState, "");
-  event_utils.def("GetParticle_First", &Event::GetParticle_First, "");
+                  py::overload_cast<HepMC3::GenEvent const &, PDGList const &>(
+                      &Event::GetParticles_AllRealFinalState),
+                  "");
+  event_utils.def(
+      "GetParticle_First",
+      py::overload_cast<HepMC3::GenEvent const &, int, PDGList const &>(
+          &Event::GetParticle_First),
+      "");
   event_utils.def("GetParticle_FirstRealFinalState",
-                  &Event::GetParticle_FirstRealFinalState, "");
-  event_utils.def("GetParticle_HighestMomentum",
-                  &Event::GetParticle_HighestMomentum, "");
+                  py::overload_cast<HepMC3::GenEvent const &, PDGList const &>(
+                      &Event::GetParticle_FirstRealFinalState),
+                  "");
+  event_utils.def(
+      "GetParticle_HighestMomentum",
+      py::overload_cast<HepMC3::GenEvent const &, int, PDGList const &>(
+          &Event::GetParticle_HighestMomentum),
+      "");
   event_utils.def("GetParticle_HighestMomentumRealFinalState",
-                  &Event::GetParticle_HighestMomentumRealFinalState, "");
-  event_utils.def("ToMeVFactor", &Event::ToMeVFactor, "");
+                  py::overload_cast<HepMC3::GenEvent const &, PDGList const &>(
+                      &Event::GetParticle_HighestMomentumRealFinalState),
+                  "");
+  event_utils.def("ToMeVFactor",
+                  py::overload_cast<HepMC3::GenEvent const &>(
+                      &Event::ToMeVFactor),
+                  "");
+  event_utils.def("ToMeVFactor",
+                  py::overload_cast<HepMC3::Units::MomentumUnit const &>(
+                      &Event::ToMeVFactor),
+                  "");
 
   event_utils.def("GetParticlesIn_All", &Vertex::GetParticlesIn_All, "");
   event_utils.def("GetParticleIn_HighestMomentum",
@@ -131,7 +171,8 @@ PYBIND11_MODULE(pyNuHepMC, m) {
   py::class_<Reader>(m, "Reader")
       .def(py::init<std::string const &>())
       .def("skip", &Reader::skip)
-      .def("read_event", &Reader::read_event)
+      .def("read_event",
+           py::overload_cast<HepMC3::GenEvent &>(&Reader::read_event))
       .def("failed", &Reader::failed)
       .def("close", &Reader::close)
       .def("set_options", &Reader::set_options)
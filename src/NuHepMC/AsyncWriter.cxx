@@ -0,0 +1,156 @@
+#include "NuHepMC/AsyncWriter.hxx"
+
+namespace NuHepMC {
+
+AsyncWriter::AsyncWriter(std::shared_ptr<HepMC3::Writer> other, size_t depth)
+    : wrtr(other), ring(depth), ring_head(0), ring_count(0),
+      worker_done(false), stop_requested(false), closed(false),
+      write_failed(false) {
+  if (!wrtr) {
+    throw NullWriter() << "NuHepMC::AsyncWriter instantiated with a nullptr.";
+  }
+  if (!depth) {
+    throw InvalidQueueDepth()
+        << "NuHepMC::AsyncWriter requires a queue depth of at least 1.";
+  }
+  HepMC3::Writer::set_run_info(wrtr->run_info());
+  worker = std::thread(&AsyncWriter::write_loop, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+  try {
+    close();
+  } catch (...) {
+    // nothing sensible to do about a failed write here
+  }
+}
+
+void AsyncWriter::write_loop() {
+  try {
+    while (true) {
+      std::unique_ptr<HepMC3::GenEvent> evt;
+      {
+        std::unique_lock<std::mutex> lock(ring_mutex);
+        ring_not_empty.wait(lock,
+                            [this] { return stop_requested || ring_count; });
+        // drain the queue before stopping
+        if (!ring_count) {
+          break;
+        }
+        evt = std::move(ring[ring_head]);
+        ring_head = (ring_head + 1) % ring.size();
+        ring_count--;
+      }
+      ring_not_full.notify_one();
+
+      // the expensive part, done without holding the lock
+      wrtr->write_event(*evt);
+      if (wrtr->failed()) {
+        throw WriteFailed() << "NuHepMC::AsyncWriter failed to write event "
+                            << evt->event_number();
+      }
+      evt->clear();
+
+      {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        recycled.push_back(std::move(evt));
+      }
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    worker_exception = std::current_exception();
+    write_failed = true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    worker_done = true;
+  }
+  ring_not_full.notify_all();
+}
+
+bool AsyncWriter::enqueue(std::unique_ptr<HepMC3::GenEvent> evt) {
+  std::unique_lock<std::mutex> lock(ring_mutex);
+  ring_not_full.wait(
+      lock, [this] { return worker_done || (ring_count < ring.size()); });
+  if (worker_done) {
+    return false;
+  }
+  ring[(ring_head + ring_count) % ring.size()] = std::move(evt);
+  ring_count++;
+  lock.unlock();
+  ring_not_empty.notify_one();
+  return true;
+}
+
+std::unique_ptr<HepMC3::GenEvent> AsyncWriter::take_recycled() {
+  std::lock_guard<std::mutex> lock(ring_mutex);
+  if (recycled.empty()) {
+    return nullptr;
+  }
+  auto evt = std::move(recycled.back());
+  recycled.pop_back();
+  return evt;
+}
+
+void AsyncWriter::write_event(std::unique_ptr<HepMC3::GenEvent> &evt) {
+  if (!evt) {
+    throw NullEvent() << "NuHepMC::AsyncWriter::write_event passed a nullptr.";
+  }
+  if (closed) {
+    return;
+  }
+
+  auto spare = take_recycled();
+  if (!spare) {
+    spare = std::make_unique<HepMC3::GenEvent>(evt->momentum_unit(),
+                                               evt->length_unit());
+  }
+  spare->set_run_info(evt->run_info());
+  std::swap(evt, spare);
+  enqueue(std::move(spare));
+}
+
+void AsyncWriter::write_event(HepMC3::GenEvent const &evt) {
+  if (closed) {
+    return;
+  }
+
+  auto copy = take_recycled();
+  if (!copy) {
+    copy = std::make_unique<HepMC3::GenEvent>();
+  }
+  *copy = evt;
+  enqueue(std::move(copy));
+}
+
+bool AsyncWriter::failed() {
+  std::lock_guard<std::mutex> lock(ring_mutex);
+  return write_failed;
+}
+
+void AsyncWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+
+  {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    stop_requested = true;
+  }
+  ring_not_empty.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+  wrtr->close();
+
+  if (worker_exception) {
+    // only rethrow once
+    auto except = worker_exception;
+    worker_exception = nullptr;
+    std::rethrow_exception(except);
+  }
+}
+
+} // namespace NuHepMC
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "NuHepMC/Exceptions.hxx"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "HepMC3/Writer.h"
+#pragma GCC diagnostic pop
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NuHepMC {
+
+// A writer that queues events into a bounded ring and serialises and
+// compresses them on a background thread, so that output overlaps with
+// whatever the caller does to produce the next event. Errors from the wrapped
+// writer are held until close, which rethrows them.
+class AsyncWriter : public HepMC3::Writer {
+
+  std::shared_ptr<HepMC3::Writer> wrtr;
+
+  // ring of events waiting to be written
+  std::vector<std::unique_ptr<HepMC3::GenEvent>> ring;
+  size_t ring_head;
+  size_t ring_count;
+
+  // cleared events that the producer can fill again
+  std::vector<std::unique_ptr<HepMC3::GenEvent>> recycled;
+
+  std::mutex ring_mutex;
+  std::condition_variable ring_not_full;
+  std::condition_variable ring_not_empty;
+
+  bool worker_done;
+  bool stop_requested;
+  bool closed;
+  bool write_failed;
+  std::exception_ptr worker_exception;
+
+  std::thread worker;
+
+  void write_loop();
+  bool enqueue(std::unique_ptr<HepMC3::GenEvent> evt);
+  std::unique_ptr<HepMC3::GenEvent> take_recycled();
+
+public:
+  NEW_NuHepMC_EXCEPT(NullWriter);
+  NEW_NuHepMC_EXCEPT(NullEvent);
+  NEW_NuHepMC_EXCEPT(InvalidQueueDepth);
+  NEW_NuHepMC_EXCEPT(WriteFailed);
+
+  // depth is the maximum number of events queued ahead of the writer
+  AsyncWriter(std::shared_ptr<HepMC3::Writer> other, size_t depth = 16);
+
+  // Closes the writer, any error is lost, call close to see it.
+  ~AsyncWriter();
+
+  // Swaps evt into the queue without copying it. evt is replaced by an empty
+  // event, re-used from those already written where possible, that the caller
+  // can fill again.
+  void write_event(std::unique_ptr<HepMC3::GenEvent> &evt);
+
+  // HepMC3::Writer interface, copies evt into the queue. Prefer the
+  // std::unique_ptr overload in hot loops.
+  void write_event(HepMC3::GenEvent const &evt);
+
+  // true once the background thread has stopped on an error, events passed
+  // after that point are dropped
+  bool failed();
+  // Writes every queued event, closes the wrapped writer, and rethrows any
+  // error hit on the background thread.
+  void close();
+
+  // must be called before the first event is written
+  void set_run_info(std::shared_ptr<HepMC3::GenRunInfo> run) {
+    HepMC3::Writer::set_run_info(run);
+    wrtr->set_run_info(run);
+  }
+};
+
+} // namespace NuHepMC
@@ -7,8 +7,10 @@
 #include "HepMC3/GenParticle.h"
 #include "HepMC3/GenRunInfo.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace NuHepMC {
 
@@ -52,72 +54,88 @@ template <typename T> bool HasAttribute(T const &obj, std::string const &name) {
          attr_names.end();
 }
 
-template <typename AT, typename T>
-bool HasAttributeOfType(T const &obj, std::string const &name) {
-  if (!obj) {
-    throw NullObjectException();
+// A handle to the attribute called name, read as type AT. Build one up front,
+// e.g. as a static, and re-use it: each query does a single typed lookup of
+// the attribute, which HepMC3 parses at most once and then caches on the
+// object. The attribute names are only scanned when building the message for
+// a failed CheckedAttributeValue. As for HepMC3::GenEvent::attribute, lookups
+// on a GenEvent fall back to its GenRunInfo.
+template <typename AT> class AttributeKey {
+public:
+  using attribute_type = typename NuHepMC::attr_traits<AT>::type;
+
+  explicit AttributeKey(std::string name) : key(std::move(name)) {}
+
+  std::string const &name() const { return key; }
+
+  // nullptr if the attribute is missing or cannot be parsed as AT
+  template <typename T>
+  std::shared_ptr<attribute_type> fetch(T const &obj) const {
+    if (!obj) {
+      throw NullObjectException();
+    }
+    return obj->template attribute<attribute_type>(key);
   }
 
-  if (!HasAttribute(obj, name)) {
-    return false;
+  template <typename T> bool has(T const &obj) const {
+    return bool(fetch(obj));
   }
 
-  if (!obj->template attribute<typename NuHepMC::attr_traits<AT>::type>(name)) {
-    return false;
+  template <typename T> auto value(T const &obj) const {
+    auto attr = fetch(obj);
+    if (!attr) {
+      throw_missing_or_mistyped(obj);
+    }
+    return attr->value();
   }
-  return true;
-}
 
-template <typename AT, typename T>
-auto CheckedAttributeValue(T const &obj, std::string const &name) {
-  if (!obj) {
-    throw NullObjectException();
+  template <typename T> auto value(T const &obj, AT const &defval) const {
+    auto attr = fetch(obj);
+    if (!attr) {
+      if (!HasAttribute(obj, key)) {
+        return defval;
+      }
+      throw_missing_or_mistyped(obj);
+    }
+    return attr->value();
   }
 
-  if (!HasAttribute(obj, name)) {
-    MissingAttributeException mae;
-    mae << "Failed to find attribute: " << name;
-    mae << "\n\tKnown attributes: \n";
-    for (auto const &a : obj->attribute_names()) {
-      mae << "\t\t" << a << "\n";
+private:
+  std::string key;
+
+  template <typename T>
+  [[noreturn]] void throw_missing_or_mistyped(T const &obj) const {
+    if (!HasAttribute(obj, key)) {
+      MissingAttributeException mae;
+      mae << "Failed to find attribute: " << key;
+      mae << "\n\tKnown attributes: \n";
+      for (auto const &a : obj->attribute_names()) {
+        mae << "\t\t" << a << "\n";
+      }
+      throw mae;
     }
-    throw mae;
-  }
 
-  if (!obj->template attribute<typename NuHepMC::attr_traits<AT>::type>(name)) {
     throw AttributeTypeException()
-        << name << ": \"" << obj->attribute_as_string(name)
+        << key << ": \"" << obj->attribute_as_string(key)
         << "\" could not be parsed as requested type: "
         << NuHepMC::attr_traits<AT>::typestr;
   }
+};
 
-  auto attr_val =
-      obj->template attribute<typename NuHepMC::attr_traits<AT>::type>(name)
-          ->value();
+template <typename AT, typename T>
+bool HasAttributeOfType(T const &obj, std::string const &name) {
+  return AttributeKey<AT>(name).has(obj);
+}
 
-  return attr_val;
+template <typename AT, typename T>
+auto CheckedAttributeValue(T const &obj, std::string const &name) {
+  return AttributeKey<AT>(name).value(obj);
 }
 
 template <typename AT, typename T>
 auto CheckedAttributeValue(T const &obj, std::string const &name,
                            AT const &defval) {
-  if (!obj) {
-    throw NullObjectException();
-  }
-
-  if (!HasAttribute(obj, name)) {
-    return defval;
-  }
-
-  if (!obj->template attribute<typename NuHepMC::attr_traits<AT>::type>(name)) {
-    throw AttributeTypeException()
-        << name << ": " << obj->attribute_as_string(name)
-        << "\" could not be parsed as requested type: "
-        << NuHepMC::attr_traits<AT>::typestr;
-  }
-
-  return obj->template attribute<typename NuHepMC::attr_traits<AT>::type>(name)
-      ->value();
+  return AttributeKey<AT>(name).value(obj, defval);
 }
 
 } // namespace NuHepMC
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "NuHepMC/ChainReader.hxx"
+
+#include "NuHepMC/ReaderUtils.hxx"
+
+#include <glob.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace NuHepMC {
+
+namespace {
+
+template <typename T> std::string to_list(T const &items) {
+  std::stringstream ss;
+  std::string sep = "[ ";
+  for (auto const &i : items) {
+    ss << sep << i;
+    sep = ", ";
+  }
+  ss << " ]";
+  return ss.str();
+}
+
+} // namespace
+
+std::string
+RunInfoIncompatibility(std::shared_ptr<HepMC3::GenRunInfo const> a,
+                       std::shared_ptr<HepMC3::GenRunInfo const> b) {
+  if (!a || !b) {
+    return (a || b) ? "only one file has a GenRunInfo" : "";
+  }
+
+  auto convs_a = GR4::ReadConventions(a);
+  auto convs_b = GR4::ReadConventions(b);
+  if (convs_a != convs_b) {
+    return "conventions differ: " + to_list(convs_a) + " vs " +
+           to_list(convs_b);
+  }
+
+  if (a->weight_names() != b->weight_names()) {
+    return "weight names differ: " + to_list(a->weight_names()) + " vs " +
+           to_list(b->weight_names());
+  }
+
+  auto units_a = GR6::ReadCrossSectionUnits(a);
+  auto units_b = GR6::ReadCrossSectionUnits(b);
+  if (units_a != units_b) {
+    return "cross section units differ: " + units_a.first + " " +
+           units_a.second + " vs " + units_b.first + " " + units_b.second;
+  }
+
+  return "";
+}
+
+std::vector<std::string> GlobFiles(std::string const &pattern) {
+  std::vector<std::string> matches;
+
+  glob_t g;
+  if (glob(pattern.c_str(), 0, nullptr, &g) == 0) {
+    for (size_t i = 0; i < g.gl_pathc; ++i) {
+      matches.emplace_back(g.gl_pathv[i]);
+    }
+  }
+  globfree(&g);
+
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+ChainReader::ChainReader(std::vector<std::string> const &fnames)
+    : filenames(fnames), current(0), run_infos(fnames.size()),
+      momentum(HepMC3::Units::GEV), length(HepMC3::Units::MM),
+      units_known(false), chain_failed(false) {
+  if (filenames.empty()) {
+    throw EmptyChain() << "NuHepMC::ChainReader instantiated with no files.";
+  }
+
+  // the first file is opened up front so that its run info is available
+  // before the first event is read
+  rdr = std::make_shared<NuHepMC::Reader>(filenames.front());
+  run_infos.front() = rdr->run_info();
+  check_compatible();
+  set_run_info(rdr->run_info());
+
+  open_ahead();
+}
+
+ChainReader::ChainReader(std::string const &pattern)
+    : ChainReader(GlobFiles(pattern)) {}
+
+ChainReader::~ChainReader() {
+  // a file being opened ahead must be waited for before it can be discarded
+  if (next.valid()) {
+    next.wait();
+  }
+}
+
+void ChainReader::open_ahead() {
+  if ((current + 1) >= filenames.size()) {
+    return;
+  }
+  next = std::async(std::launch::async, [fname = filenames[current + 1]]() {
+    return std::make_shared<NuHepMC::Reader>(fname);
+  });
+}
+
+bool ChainReader::next_file() {
+  if ((current + 1) >= filenames.size()) {
+    return false;
+  }
+  rdr->close();
+
+  // rethrows anything thrown while opening the file
+  auto opened = next.get();
+  current++;
+  rdr = opened;
+  run_infos[current] = rdr->run_info();
+  check_compatible();
+  set_run_info(rdr->run_info());
+
+  open_ahead();
+  return true;
+}
+
+void ChainReader::check_compatible() {
+  auto why = RunInfoIncompatibility(run_infos.front(), run_infos[current]);
+
+  // files without events have no units to compare
+  if (why.empty() && !rdr->failed()) {
+    if (!units_known) {
+      momentum = rdr->momentum_unit();
+      length = rdr->length_unit();
+      units_known = true;
+    } else if ((rdr->momentum_unit() != momentum) ||
+               (rdr->length_unit() != length)) {
+      why = "event units differ";
+    }
+  }
+
+  if (why.size()) {
+    throw IncompatibleRunInfo()
+        << "File " << filenames[current] << " cannot be chained with "
+        << filenames.front() << ", " << why;
+  }
+}
+
+bool ChainReader::read_event(HepMC3::GenEvent &evt) {
+  if (chain_failed) {
+    return false;
+  }
+  do {
+    rdr->read_event(evt);
+    if (!rdr->failed()) {
+      return true;
+    }
+  } while (next_file());
+
+  chain_failed = true;
+  return false;
+}
+
+bool ChainReader::skip(const int n) {
+  if (chain_failed) {
+    return false;
+  }
+  for (int i = 0; i < n;) {
+    rdr->skip(1);
+    if (!rdr->failed()) {
+      i++;
+    } else if (!next_file()) {
+      chain_failed = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+void ChainReader::close() {
+  if (next.valid()) {
+    next.wait();
+  }
+  rdr->close();
+  chain_failed = true;
+}
+
+} // namespace NuHepMC
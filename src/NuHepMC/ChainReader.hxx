@@ -0,0 +1,72 @@
+#pragma once
+
+#include "NuHepMC/Reader.hxx"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NuHepMC {
+
+// Describes the first difference between two run infos that makes it unsafe to
+// analyse their events together: differing conventions, weight names, or cross
+// section units. Empty if there is none.
+std::string
+RunInfoIncompatibility(std::shared_ptr<HepMC3::GenRunInfo const> a,
+                       std::shared_ptr<HepMC3::GenRunInfo const> b);
+
+// The files matching a shell wildcard pattern, in sorted order
+std::vector<std::string> GlobFiles(std::string const &pattern);
+
+// Reads the events of a list of files one after another as a single stream.
+// The next file is opened, and its header and first event decoded, on a
+// background thread while the current one is being read, so there is no
+// stall at file boundaries. Every file must be compatible with the first, see
+// RunInfoIncompatibility.
+class ChainReader : public HepMC3::Reader {
+
+  std::vector<std::string> filenames;
+  size_t current;
+  std::shared_ptr<NuHepMC::Reader> rdr;
+  std::future<std::shared_ptr<NuHepMC::Reader>> next;
+
+  // filled in as each file is opened
+  std::vector<std::shared_ptr<HepMC3::GenRunInfo>> run_infos;
+  HepMC3::Units::MomentumUnit momentum;
+  HepMC3::Units::LengthUnit length;
+  bool units_known;
+
+  bool chain_failed;
+
+  void open_ahead();
+  // moves on to the next file in the chain, returns false if there is none
+  bool next_file();
+  void check_compatible();
+
+public:
+  NEW_NuHepMC_EXCEPT(EmptyChain);
+  NEW_NuHepMC_EXCEPT(IncompatibleRunInfo);
+
+  ChainReader(std::vector<std::string> const &filenames);
+  // all files matching pattern, see GlobFiles
+  ChainReader(std::string const &pattern);
+
+  ~ChainReader();
+
+  bool read_event(HepMC3::GenEvent &evt);
+  bool skip(const int n);
+  bool failed() { return chain_failed; }
+  void close();
+
+  size_t nfiles() const { return filenames.size(); }
+  // The position in the chain of the file that the last event was read from
+  size_t file_index() const { return current; }
+  std::string const &file_name() const { return filenames[current]; }
+  // nullptr for files that have not been opened yet
+  std::shared_ptr<HepMC3::GenRunInfo> file_run_info(size_t ifile) const {
+    return run_infos.at(ifile);
+  }
+};
+
+} // namespace NuHepMC
@@ -0,0 +1,694 @@
+#include "NuHepMC/CompressedStreams.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#if HEPMC3_Z_SUPPORT == 1
+#include <zlib.h>
+#endif
+#if HEPMC3_LZMA_SUPPORT == 1
+#include <lzma.h>
+#endif
+#if HEPMC3_BZ2_SUPPORT == 1
+#include <bzlib.h>
+#endif
+#if HEPMC3_ZSTD_SUPPORT == 1
+#include <zstd.h>
+#endif
+
+namespace NuHepMC {
+
+namespace Compression {
+
+std::string to_string(Format fmt) {
+  switch (fmt) {
+  case Format::kNone: {
+    return "none";
+  }
+  case Format::kZ: {
+    return "gzip";
+  }
+  case Format::kLZMA: {
+    return "xz/lzma";
+  }
+  case Format::kBZip2: {
+    return "bzip2";
+  }
+  case Format::kZstd: {
+    return "zstd";
+  }
+  default: {
+    return "unknown";
+  }
+  }
+}
+
+Format DetectFormat(char const *magic, size_t nbytes) {
+  auto const *m = reinterpret_cast<unsigned char const *>(magic);
+
+  if ((nbytes >= 2) && (m[0] == 0x1f) && (m[1] == 0x8b)) {
+    return Format::kZ;
+  } else if ((nbytes >= 3) && (m[0] == 'B') && (m[1] == 'Z') &&
+             (m[2] == 'h')) {
+    return Format::kBZip2;
+  } else if ((nbytes >= 6) && (m[0] == 0xfd) && (m[1] == '7') &&
+             (m[2] == 'z') && (m[3] == 'X') && (m[4] == 'Z') &&
+             (m[5] == 0x00)) {
+    return Format::kLZMA;
+  } else if ((nbytes >= 4) && (m[0] == 0x28) && (m[1] == 0xb5) &&
+             (m[2] == 0x2f) && (m[3] == 0xfd)) {
+    return Format::kZstd;
+  } else if ((nbytes >= 3) && (m[0] == 0x5d) && (m[1] == 0x00) &&
+             (m[2] == 0x00)) { // legacy .lzma
+    return Format::kLZMA;
+  }
+  return Format::kNone;
+}
+
+Format DetectFormat(std::string const &filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  char magic[6];
+  ifs.read(magic, sizeof(magic));
+  return DetectFormat(magic, size_t(ifs.gcount()));
+}
+
+#if HEPMC3_Z_SUPPORT == 1
+struct ZDecoder : public Decoder {
+  z_stream strm;
+
+  ZDecoder() {
+    std::memset(&strm, 0, sizeof(strm));
+    // 32 enables automatic gzip/zlib header detection
+    if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+      throw DecompressionError() << "zlib inflateInit2 failed.";
+    }
+  }
+  ~ZDecoder() { inflateEnd(&strm); }
+
+  bool decode(char const *&in, size_t &in_avail, char *&out,
+              size_t &out_avail) {
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+    strm.avail_in = uInt(in_avail);
+    strm.next_out = reinterpret_cast<Bytef *>(out);
+    strm.avail_out = uInt(out_avail);
+
+    int ret = inflate(&strm, Z_NO_FLUSH);
+
+    in += (in_avail - strm.avail_in);
+    in_avail = strm.avail_in;
+    out += (out_avail - strm.avail_out);
+    out_avail = strm.avail_out;
+
+    if (ret == Z_STREAM_END) {
+      return true;
+    }
+    if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+      throw DecompressionError() << "zlib inflate failed with code: " << ret;
+    }
+    return false;
+  }
+  void reset() { inflateReset(&strm); }
+};
+#endif
+
+#if HEPMC3_LZMA_SUPPORT == 1
+struct LZMADecoder : public Decoder {
+  lzma_stream strm;
+
+  void init() {
+    strm = LZMA_STREAM_INIT;
+    if (lzma_auto_decoder(&strm, UINT64_MAX, 0) != LZMA_OK) {
+      throw DecompressionError() << "lzma_auto_decoder failed.";
+    }
+  }
+
+  LZMADecoder() { init(); }
+  ~LZMADecoder() { lzma_end(&strm); }
+
+  bool decode(char const *&in, size_t &in_avail, char *&out,
+              size_t &out_avail) {
+    strm.next_in = reinterpret_cast<uint8_t const *>(in);
+    strm.avail_in = in_avail;
+    strm.next_out = reinterpret_cast<uint8_t *>(out);
+    strm.avail_out = out_avail;
+
+    lzma_ret ret = lzma_code(&strm, LZMA_RUN);
+
+    in += (in_avail - strm.avail_in);
+    in_avail = strm.avail_in;
+    out += (out_avail - strm.avail_out);
+    out_avail = strm.avail_out;
+
+    if (ret == LZMA_STREAM_END) {
+      return true;
+    }
+    if ((ret != LZMA_OK) && (ret != LZMA_BUF_ERROR)) {
+      throw DecompressionError() << "lzma_code failed with code: " << ret;
+    }
+    return false;
+  }
+  void reset() {
+    lzma_end(&strm);
+    init();
+  }
+};
+#endif
+
+#if HEPMC3_BZ2_SUPPORT == 1
+struct BZip2Decoder : public Decoder {
+  bz_stream strm;
+
+  void init() {
+    std::memset(&strm, 0, sizeof(strm));
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+      throw DecompressionError() << "BZ2_bzDecompressInit failed.";
+    }
+  }
+
+  BZip2Decoder() { init(); }
+  ~BZip2Decoder() { BZ2_bzDecompressEnd(&strm); }
+
+  bool decode(char const *&in, size_t &in_avail, char *&out,
+              size_t &out_avail) {
+    strm.next_in = const_cast<char *>(in);
+    strm.avail_in = static_cast<unsigned int>(in_avail);
+    strm.next_out = out;
+    strm.avail_out = static_cast<unsigned int>(out_avail);
+
+    int ret = BZ2_bzDecompress(&strm);
+
+    in += (in_avail - strm.avail_in);
+    in_avail = strm.avail_in;
+    out += (out_avail - strm.avail_out);
+    out_avail = strm.avail_out;
+
+    if (ret == BZ_STREAM_END) {
+      return true;
+    }
+    if (ret != BZ_OK) {
+      throw DecompressionError() << "BZ2_bzDecompress failed with code: "
+                                 << ret;
+    }
+    return false;
+  }
+  void reset() {
+    BZ2_bzDecompressEnd(&strm);
+    init();
+  }
+};
+#endif
+
+#if HEPMC3_ZSTD_SUPPORT == 1
+struct ZstdDecoder : public Decoder {
+  ZSTD_DCtx *dctx;
+
+  ZstdDecoder() : dctx(ZSTD_createDCtx()) {
+    if (!dctx) {
+      throw DecompressionError() << "ZSTD_createDCtx failed.";
+    }
+  }
+  ~ZstdDecoder() { ZSTD_freeDCtx(dctx); }
+
+  bool decode(char const *&in, size_t &in_avail, char *&out,
+              size_t &out_avail) {
+    ZSTD_inBuffer ib{in, in_avail, 0};
+    ZSTD_outBuffer ob{out, out_avail, 0};
+
+    size_t ret = ZSTD_decompressStream(dctx, &ob, &ib);
+
+    in += ib.pos;
+    in_avail -= ib.pos;
+    out += ob.pos;
+    out_avail -= ob.pos;
+
+    if (ZSTD_isError(ret)) {
+      throw DecompressionError()
+          << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(ret);
+    }
+    // 0 signals that a frame has been fully decoded and flushed
+    return ret == 0;
+  }
+  void reset() { ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only); }
+};
+#endif
+
+std::unique_ptr<Decoder> MakeDecoder(Format fmt) {
+  switch (fmt) {
+  case Format::kZ: {
+#if HEPMC3_Z_SUPPORT == 1
+    return std::make_unique<ZDecoder>();
+#else
+    break;
+#endif
+  }
+  case Format::kLZMA: {
+#if HEPMC3_LZMA_SUPPORT == 1
+    return std::make_unique<LZMADecoder>();
+#else
+    break;
+#endif
+  }
+  case Format::kBZip2: {
+#if HEPMC3_BZ2_SUPPORT == 1
+    return std::make_unique<BZip2Decoder>();
+#else
+    break;
+#endif
+  }
+  case Format::kZstd: {
+#if HEPMC3_ZSTD_SUPPORT == 1
+    return std::make_unique<ZstdDecoder>();
+#else
+    break;
+#endif
+  }
+  default: {
+    break;
+  }
+  }
+  throw UnsupportedCompression()
+      << "NuHepMC_CPPUtils was built without support for decompressing "
+      << to_string(fmt) << " streams.";
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(
+    std::shared_ptr<std::istream> src, Format fmt, size_t buffer_size)
+    : source(src), decoder(MakeDecoder(fmt)), in_buf(buffer_size),
+      out_buf(buffer_size), in_next(nullptr), in_avail(0),
+      member_ended(false) {}
+
+bool DecompressingStreamBuf::fill_input() {
+  if (in_avail) {
+    return true;
+  }
+  source->read(in_buf.data(), std::streamsize(in_buf.size()));
+  in_avail = size_t(source->gcount());
+  in_next = in_buf.data();
+  return in_avail;
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+
+  char *out = out_buf.data();
+  size_t out_avail = out_buf.size();
+
+  while (out == out_buf.data()) {
+    // the decoder may still hold output even once the source is exhausted
+    bool eof = !fill_input();
+
+    if (member_ended) {
+      // skip any zero-padding between members
+      while (in_avail && (*in_next == '\0')) {
+        in_next++;
+        in_avail--;
+      }
+      if (!in_avail) {
+        if (eof) {
+          break;
+        }
+        continue;
+      }
+      decoder->reset();
+      member_ended = false;
+    }
+
+    member_ended = decoder->decode(in_next, in_avail, out, out_avail);
+
+    if (eof && (out == out_buf.data())) {
+      break;
+    }
+  }
+
+  if (out == out_buf.data()) {
+    return traits_type::eof();
+  }
+
+  setg(out_buf.data(), out_buf.data(), out);
+  return traits_type::to_int_type(*gptr());
+}
+
+void CompressMember(Format fmt, char const *in, size_t nbytes,
+                    std::vector<char> &out, int level) {
+  // some libraries reject a null input even when it is empty
+  static char const empty = '\0';
+  if (!nbytes) {
+    in = &empty;
+  }
+
+  switch (fmt) {
+  case Format::kZ: {
+#if HEPMC3_Z_SUPPORT == 1
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    // 16 writes a gzip header and trailer rather than a zlib one
+    if (deflateInit2(&strm, (level < 0) ? Z_DEFAULT_COMPRESSION : level,
+                     Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw CompressionError() << "zlib deflateInit2 failed.";
+    }
+    out.resize(deflateBound(&strm, uLong(nbytes)));
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+    strm.avail_in = uInt(nbytes);
+    strm.next_out = reinterpret_cast<Bytef *>(out.data());
+    strm.avail_out = uInt(out.size());
+    int ret = deflate(&strm, Z_FINISH);
+    out.resize(strm.total_out);
+    deflateEnd(&strm);
+    if (ret != Z_STREAM_END) {
+      throw CompressionError() << "zlib deflate failed with code: " << ret;
+    }
+    return;
+#else
+    break;
+#endif
+  }
+  case Format::kLZMA: {
+#if HEPMC3_LZMA_SUPPORT == 1
+    out.resize(lzma_stream_buffer_bound(nbytes));
+    size_t out_pos = 0;
+    lzma_ret ret = lzma_easy_buffer_encode(
+        (level < 0) ? LZMA_PRESET_DEFAULT : uint32_t(level), LZMA_CHECK_CRC64,
+        nullptr, reinterpret_cast<uint8_t const *>(in), nbytes,
+        reinterpret_cast<uint8_t *>(out.data()), &out_pos, out.size());
+    if (ret != LZMA_OK) {
+      throw CompressionError()
+          << "lzma_easy_buffer_encode failed with code: " << ret;
+    }
+    out.resize(out_pos);
+    return;
+#else
+    break;
+#endif
+  }
+  case Format::kBZip2: {
+#if HEPMC3_BZ2_SUPPORT == 1
+    // the documented worst case is 1% larger plus 600 bytes
+    auto out_size = static_cast<unsigned int>(nbytes + nbytes / 100 + 600);
+    out.resize(out_size);
+    int ret = BZ2_bzBuffToBuffCompress(
+        out.data(), &out_size, const_cast<char *>(in),
+        static_cast<unsigned int>(nbytes), (level < 1) ? 9 : level, 0, 0);
+    if (ret != BZ_OK) {
+      throw CompressionError()
+          << "BZ2_bzBuffToBuffCompress failed with code: " << ret;
+    }
+    out.resize(out_size);
+    return;
+#else
+    break;
+#endif
+  }
+  case Format::kZstd: {
+#if HEPMC3_ZSTD_SUPPORT == 1
+    out.resize(ZSTD_compressBound(nbytes));
+    size_t ret = ZSTD_compress(out.data(), out.size(), in, nbytes,
+                               (level < 0) ? ZSTD_CLEVEL_DEFAULT : level);
+    if (ZSTD_isError(ret)) {
+      throw CompressionError()
+          << "ZSTD_compress failed: " << ZSTD_getErrorName(ret);
+    }
+    out.resize(ret);
+    return;
+#else
+    break;
+#endif
+  }
+  default: {
+    break;
+  }
+  }
+  throw UnsupportedCompression()
+      << "NuHepMC_CPPUtils was built without support for compressing "
+      << to_string(fmt) << " streams.";
+}
+
+ParallelCompressingStreamBuf::ParallelCompressingStreamBuf(
+    std::shared_ptr<std::ostream> snk, Format f, size_t nthreads,
+    size_t bsize, int lvl, bool acut)
+    : sink(snk), fmt(f), level(lvl), block_size(bsize), auto_cut(acut),
+      max_in_flight(0), put_buf(bsize), nblocks(0), finished(false),
+      block_start(0), nwritten(0), stop_requested(false) {
+  if (!block_size) {
+    throw CompressionError() << "ParallelCompressingStreamBuf requires a "
+                                "block size of at least 1 byte.";
+  }
+  // fail now rather than on the first full block
+  std::vector<char> probe;
+  CompressMember(fmt, nullptr, 0, probe, level);
+
+  if (!nthreads) {
+    nthreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  max_in_flight = 2 * nthreads;
+  for (size_t i = 0; i < nthreads; ++i) {
+    workers.emplace_back(&ParallelCompressingStreamBuf::work_loop, this);
+  }
+  setp(put_buf.data(), put_buf.data() + put_buf.size());
+}
+
+ParallelCompressingStreamBuf::~ParallelCompressingStreamBuf() {
+  try {
+    finish();
+  } catch (...) {
+    // nothing sensible to do about a failed write here
+  }
+  stop_workers();
+}
+
+void ParallelCompressingStreamBuf::work_loop() {
+  while (true) {
+    std::shared_ptr<Block> block;
+    {
+      std::unique_lock<std::mutex> lock(pool_mutex);
+      work_ready.wait(lock, [this] { return stop_requested || todo.size(); });
+      if (todo.empty()) {
+        break;
+      }
+      block = todo.front();
+      todo.pop_front();
+    }
+
+    // the expensive part, done without holding the lock
+    try {
+      CompressMember(fmt, block->in.data(), block->in.size(), block->out,
+                     level);
+    } catch (...) {
+      block->error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      block->done = true;
+    }
+    work_done.notify_all();
+  }
+}
+
+void ParallelCompressingStreamBuf::submit_block() {
+  auto block = std::make_shared<Block>();
+  block->done = false;
+  block->in.assign(pbase(), pptr());
+  block->offset = block_start;
+  block_start += block->in.size();
+  setp(put_buf.data(), put_buf.data() + put_buf.size());
+  nblocks++;
+
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    in_flight.push_back(block);
+    todo.push_back(block);
+  }
+  work_ready.notify_one();
+}
+
+void ParallelCompressingStreamBuf::write_completed(size_t max_blocks) {
+  while (true) {
+    std::shared_ptr<Block> block;
+    {
+      std::unique_lock<std::mutex> lock(pool_mutex);
+      if (in_flight.empty()) {
+        return;
+      }
+      if (in_flight.size() > max_blocks) {
+        work_done.wait(lock, [this] { return in_flight.front()->done; });
+      } else if (!in_flight.front()->done) {
+        return;
+      }
+      block = in_flight.front();
+      in_flight.pop_front();
+    }
+
+    if (block->error) {
+      std::rethrow_exception(block->error);
+    }
+    sink->write(block->out.data(), std::streamsize(block->out.size()));
+    if (!*sink) {
+      throw CompressionError() << "Failed to write compressed block.";
+    }
+    written_offsets.emplace_back(nwritten, block->offset);
+    nwritten += block->out.size();
+  }
+}
+
+void ParallelCompressingStreamBuf::stop_workers() {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    stop_requested = true;
+  }
+  work_ready.notify_all();
+  for (auto &worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+ParallelCompressingStreamBuf::int_type
+ParallelCompressingStreamBuf::overflow(int_type ch) {
+  if (finished) {
+    return traits_type::eof();
+  }
+  if (!auto_cut) {
+    // grow the block rather than cutting it anywhere but a boundary
+    size_t nput = size_t(pptr() - pbase());
+    put_buf.resize(2 * put_buf.size());
+    setp(put_buf.data(), put_buf.data() + put_buf.size());
+    // pbump takes an int, and a block can grow past INT_MAX bytes
+    while (nput) {
+      size_t step = std::min(nput, size_t(std::numeric_limits<int>::max()));
+      pbump(int(step));
+      nput -= step;
+    }
+  } else {
+    try {
+      submit_block();
+      write_completed(max_in_flight);
+    } catch (...) {
+      return traits_type::eof();
+    }
+  }
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+int ParallelCompressingStreamBuf::sync() {
+  if (finished) {
+    return 0;
+  }
+  try {
+    write_completed(in_flight.size());
+  } catch (...) {
+    return -1;
+  }
+  sink->flush();
+  return *sink ? 0 : -1;
+}
+
+void ParallelCompressingStreamBuf::mark_boundary() {
+  if (finished || (size_t(pptr() - pbase()) < block_size)) {
+    return;
+  }
+  submit_block();
+  write_completed(max_in_flight);
+}
+
+void ParallelCompressingStreamBuf::finish() {
+  if (finished) {
+    return;
+  }
+  finished = true;
+
+  try {
+    // an empty stream still gets one member so that the output is valid
+    if ((pptr() > pbase()) || !nblocks) {
+      submit_block();
+    }
+    write_completed(0);
+  } catch (...) {
+    stop_workers();
+    throw;
+  }
+  stop_workers();
+  setp(nullptr, nullptr);
+
+  sink->flush();
+  if (!*sink) {
+    throw CompressionError() << "Failed to flush compressed stream.";
+  }
+}
+
+std::shared_ptr<ParallelCompressingOStream>
+OpenCompressed(std::string const &filename, Format fmt, size_t nthreads,
+               size_t block_size, int level, bool auto_cut) {
+  auto raw = std::make_shared<std::ofstream>(filename, std::ios::binary);
+  if (!*raw) {
+    throw CompressionError() << "Failed to open " << filename
+                             << " for writing.";
+  }
+  return std::make_shared<ParallelCompressingOStream>(
+      raw, fmt, nthreads, block_size, level, auto_cut);
+}
+
+std::shared_ptr<std::istream> OpenDecompressed(std::string const &filename) {
+  auto raw = std::make_shared<std::ifstream>(filename, std::ios::binary);
+  auto fmt = DetectFormat(filename);
+  if (fmt == Format::kNone) {
+    return raw;
+  }
+  return std::make_shared<DecompressingIStream>(raw, fmt);
+}
+
+PrefixedStreamBuf::PrefixedStreamBuf(std::string pfx,
+                                     std::shared_ptr<std::istream> src,
+                                     size_t buffer_size)
+    : prefix(std::move(pfx)), source(src), buf(buffer_size),
+      prefix_done(false) {}
+
+PrefixedStreamBuf::int_type PrefixedStreamBuf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  if (!prefix_done) {
+    prefix_done = true;
+    if (prefix.size()) {
+      setg(&prefix[0], &prefix[0], &prefix[0] + prefix.size());
+      return traits_type::to_int_type(*gptr());
+    }
+  }
+  source->read(buf.data(), std::streamsize(buf.size()));
+  auto got = source->gcount();
+  if (!got) {
+    return traits_type::eof();
+  }
+  setg(buf.data(), buf.data(), buf.data() + got);
+  return traits_type::to_int_type(*gptr());
+}
+
+std::pair<std::string, std::shared_ptr<std::istream>>
+Peek(std::shared_ptr<std::istream> source, size_t nbytes) {
+  std::string head(nbytes, '\0');
+  source->read(&head[0], std::streamsize(nbytes));
+  head.resize(size_t(source->gcount()));
+  return {head, std::make_shared<PrefixedIStream>(head, source)};
+}
+
+std::shared_ptr<std::istream>
+OpenDecompressed(std::shared_ptr<std::istream> source) {
+  auto peeked = Peek(source, 6);
+  auto fmt = DetectFormat(peeked.first.data(), peeked.first.size());
+  if (fmt == Format::kNone) {
+    return peeked.second;
+  }
+  return std::make_shared<DecompressingIStream>(peeked.second, fmt);
+}
+
+} // namespace Compression
+
+} // namespace NuHepMC
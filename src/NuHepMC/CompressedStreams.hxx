@@ -0,0 +1,267 @@
+#pragma once
+
+#include "NuHepMC/HepMC3Features.hxx"
+
+#include "NuHepMC/Exceptions.hxx"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace NuHepMC {
+
+namespace Compression {
+
+NEW_NuHepMC_EXCEPT(UnsupportedCompression);
+NEW_NuHepMC_EXCEPT(DecompressionError);
+NEW_NuHepMC_EXCEPT(CompressionError);
+
+enum class Format {
+  kNone = 0,
+  kZ = 10,
+  kLZMA = 20,
+  kBZip2 = 30,
+  kZstd = 40,
+};
+
+std::string to_string(Format fmt);
+
+// Guesses the compression format from the magic bytes at the start of a
+// stream, returns kNone if none match.
+Format DetectFormat(char const *magic, size_t nbytes);
+Format DetectFormat(std::string const &filename);
+
+// Incrementally decodes a single compressed member (a gzip member, a bzip2
+// stream, an xz stream, or a zstd frame). Compressed files may be made of many
+// concatenated members, and each is a point at which decoding can start from
+// scratch.
+struct Decoder {
+  // Decodes from in into out, advancing both pointers and decrementing both
+  // counts. Returns true when the end of the current member has been reached,
+  // reset() must then be called before decoding the next member.
+  virtual bool decode(char const *&in, size_t &in_avail, char *&out,
+                      size_t &out_avail) = 0;
+  virtual void reset() = 0;
+  virtual ~Decoder() {}
+};
+
+std::unique_ptr<Decoder> MakeDecoder(Format fmt);
+
+// A read-only streambuf that decompresses a source stream made of one or more
+// concatenated compressed members.
+class DecompressingStreamBuf : public std::streambuf {
+  std::shared_ptr<std::istream> source;
+  std::unique_ptr<Decoder> decoder;
+
+  std::vector<char> in_buf;
+  std::vector<char> out_buf;
+  char const *in_next;
+  size_t in_avail;
+  bool member_ended;
+
+  bool fill_input();
+
+protected:
+  int_type underflow();
+
+public:
+  DecompressingStreamBuf(std::shared_ptr<std::istream> source, Format fmt,
+                         size_t buffer_size = 1 << 18);
+};
+
+// An istream that owns its DecompressingStreamBuf
+class DecompressingIStream : public std::istream {
+  DecompressingStreamBuf buf;
+
+public:
+  DecompressingIStream(std::shared_ptr<std::istream> source, Format fmt)
+      : std::istream(nullptr), buf(source, fmt) {
+    rdbuf(&buf);
+  }
+};
+
+// Compresses nbytes from in into out as a single, self-contained member (a
+// gzip member, a bzip2 stream, an xz stream, or a zstd frame) that can be
+// decoded without anything written before it. level is the usual 1 - 9 scale
+// (1 - 22 for zstd), or -1 for the library default.
+void CompressMember(Format fmt, char const *in, size_t nbytes,
+                    std::vector<char> &out, int level = -1);
+
+// A write-only streambuf that cuts the stream into blocks of block_size
+// bytes and compresses each into an independent member on a pool of threads.
+// Members are written to the sink in order, so the output is a standard
+// multi-member file that any decoder for the format can read, and every block
+// is a point at which decompression can start from scratch.
+//
+// With auto_cut unset, blocks are only ever cut at calls to mark_boundary()
+// and the block being filled grows as needed, so that every block starts at a
+// point chosen by the caller, such as the start of an event record.
+class ParallelCompressingStreamBuf : public std::streambuf {
+  struct Block {
+    std::vector<char> in;
+    std::vector<char> out;
+    // the offset of the first byte of in in the uncompressed stream
+    uint64_t offset;
+    bool done;
+    std::exception_ptr error;
+  };
+
+  std::shared_ptr<std::ostream> sink;
+  Format fmt;
+  int level;
+  size_t block_size;
+  bool auto_cut;
+  // the most blocks held in memory at once, in compression or awaiting output
+  size_t max_in_flight;
+
+  std::vector<char> put_buf;
+  size_t nblocks;
+  bool finished;
+
+  // the uncompressed offset of the block being filled
+  uint64_t block_start;
+  // compressed bytes written to the sink so far
+  uint64_t nwritten;
+  std::vector<std::pair<uint64_t, uint64_t>> written_offsets;
+
+  // blocks in stream order, those at the front are written once done
+  std::deque<std::shared_ptr<Block>> in_flight;
+  // blocks waiting for a worker
+  std::deque<std::shared_ptr<Block>> todo;
+
+  std::mutex pool_mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  bool stop_requested;
+  std::vector<std::thread> workers;
+
+  void work_loop();
+  void submit_block();
+  // writes the completed blocks at the front of the stream, waiting until at
+  // most max_blocks are left in flight
+  void write_completed(size_t max_blocks);
+  void stop_workers();
+
+protected:
+  int_type overflow(int_type ch);
+  // only writes blocks that are already compressed, the block being filled is
+  // not cut short, so frequent flushes do not degrade the compression ratio
+  int sync();
+
+public:
+  // nthreads = 0 uses one thread per hardware core
+  ParallelCompressingStreamBuf(std::shared_ptr<std::ostream> sink, Format fmt,
+                               size_t nthreads = 0,
+                               size_t block_size = 4 << 20, int level = -1,
+                               bool auto_cut = true);
+  ~ParallelCompressingStreamBuf();
+
+  // Marks a point at which a new block may start, the block being filled is
+  // cut here if it already holds at least block_size bytes.
+  void mark_boundary();
+
+  // the number of uncompressed bytes put so far
+  uint64_t uncompressed_size() const {
+    return block_start + uint64_t(pptr() - pbase());
+  }
+  // the bytes put since the block being filled was started, at
+  // uncompressed offset current_block_start()
+  std::string_view current_block() const {
+    return std::string_view(pbase(), size_t(pptr() - pbase()));
+  }
+  uint64_t current_block_start() const { return block_start; }
+
+  // (compressed offset, uncompressed offset) pairs at the start of every block
+  // written to the sink so far
+  std::vector<std::pair<uint64_t, uint64_t>> const &block_offsets() const {
+    return written_offsets;
+  }
+
+  // Compresses and writes everything put so far and stops the pool, nothing
+  // can be written afterwards. Throws CompressionError if any block failed.
+  void finish();
+};
+
+// An ostream that owns its ParallelCompressingStreamBuf
+class ParallelCompressingOStream : public std::ostream {
+  ParallelCompressingStreamBuf buf;
+
+public:
+  ParallelCompressingOStream(std::shared_ptr<std::ostream> sink, Format fmt,
+                             size_t nthreads = 0, size_t block_size = 4 << 20,
+                             int level = -1, bool auto_cut = true)
+      : std::ostream(nullptr),
+        buf(sink, fmt, nthreads, block_size, level, auto_cut) {
+    rdbuf(&buf);
+  }
+
+  ParallelCompressingStreamBuf &blocks() { return buf; }
+
+  void finish() {
+    flush();
+    buf.finish();
+  }
+};
+
+// Opens filename for writing, compressing everything written with fmt across
+// nthreads threads.
+std::shared_ptr<ParallelCompressingOStream>
+OpenCompressed(std::string const &filename, Format fmt, size_t nthreads = 0,
+               size_t block_size = 4 << 20, int level = -1,
+               bool auto_cut = true);
+
+// Opens filename for reading, transparently decompressing it if its magic
+// bytes signal a supported compression format.
+std::shared_ptr<std::istream> OpenDecompressed(std::string const &filename);
+
+// Serves prefix, then everything left in source, so that the start of a
+// stream that cannot be rewound, like a pipe, can be inspected and the whole
+// stream still read afterwards
+class PrefixedStreamBuf : public std::streambuf {
+  std::string prefix;
+  std::shared_ptr<std::istream> source;
+  std::vector<char> buf;
+  bool prefix_done;
+
+protected:
+  int_type underflow();
+
+public:
+  PrefixedStreamBuf(std::string prefix, std::shared_ptr<std::istream> source,
+                    size_t buffer_size = 1 << 18);
+};
+
+class PrefixedIStream : public std::istream {
+  PrefixedStreamBuf buf;
+
+public:
+  PrefixedIStream(std::string prefix, std::shared_ptr<std::istream> source)
+      : std::istream(nullptr), buf(std::move(prefix), source) {
+    rdbuf(&buf);
+  }
+};
+
+// Reads up to nbytes from the front of source, returning them along with a
+// stream that still yields every byte of source.
+std::pair<std::string, std::shared_ptr<std::istream>>
+Peek(std::shared_ptr<std::istream> source, size_t nbytes);
+
+// Transparently decompresses source if its magic bytes signal a supported
+// compression format. source is only read through once, so it may be a pipe.
+std::shared_ptr<std::istream>
+OpenDecompressed(std::shared_ptr<std::istream> source);
+
+} // namespace Compression
+
+} // namespace NuHepMC
@@ -0,0 +1,94 @@
+#include "NuHepMC/EventHeader.hxx"
+
+#include "NuHepMC/AttributeUtils.hxx"
+
+#include <algorithm>
+
+namespace NuHepMC {
+
+void EventHeaderDecoder::decode(HepMC3::GenEvent const &evt,
+                                EventHeader &header) {
+  static AttributeKey<int> const process_id_key("signal_process_id");
+  static AttributeKey<std::vector<double>> const lab_pos_key("lab_pos");
+  static AttributeKey<double> const tot_xs_key("tot_xs");
+  static AttributeKey<double> const proc_xs_key("proc_xs");
+
+  header = EventHeader{};
+  header.event_number = evt.event_number();
+
+  auto const &gri = evt.run_info();
+  if (gri != run_info) {
+    run_info = gri;
+    cv_index = run_info ? run_info->weight_index("CV") : -1;
+  }
+
+  if (auto attr = process_id_key.fetch(&evt)) {
+    header.process_id = attr->value();
+    header.present |= EventHeader::kProcessID;
+  }
+
+  if (auto attr = lab_pos_key.fetch(&evt)) {
+    auto const &pos = attr->value();
+    std::copy_n(pos.begin(), std::min(pos.size(), header.lab_position.size()),
+                header.lab_position.begin());
+    header.present |= EventHeader::kLabPosition;
+  }
+
+  if (auto attr = tot_xs_key.fetch(&evt)) {
+    header.total_xsec = attr->value();
+    header.present |= EventHeader::kTotalXSec;
+  }
+
+  if (auto attr = proc_xs_key.fetch(&evt)) {
+    header.process_xsec = attr->value();
+    header.present |= EventHeader::kProcessXSec;
+  }
+
+  size_t const xs_index = (cv_index < 0) ? 0 : size_t(cv_index);
+  if (auto xs = evt.cross_section()) {
+    if (xs_index < xs->xsecs().size()) {
+      header.fatx_best_estimate = xs->xsecs()[xs_index];
+      header.present |= EventHeader::kFATXBestEstimate;
+    }
+  }
+
+  if ((cv_index >= 0) && (size_t(cv_index) < evt.weights().size())) {
+    header.cv_weight = evt.weights()[size_t(cv_index)];
+    header.present |= EventHeader::kCVWeight;
+  }
+}
+
+EventHeaderColumns::EventHeaderColumns(size_t capacity) : cap(capacity) {
+  present.reserve(cap);
+  event_number.reserve(cap);
+  process_id.reserve(cap);
+  lab_position.reserve(cap);
+  total_xsec.reserve(cap);
+  process_xsec.reserve(cap);
+  fatx_best_estimate.reserve(cap);
+  cv_weight.reserve(cap);
+}
+
+void EventHeaderColumns::push_back(EventHeader const &header) {
+  present.push_back(header.present);
+  event_number.push_back(header.event_number);
+  process_id.push_back(header.process_id);
+  lab_position.push_back(header.lab_position);
+  total_xsec.push_back(header.total_xsec);
+  process_xsec.push_back(header.process_xsec);
+  fatx_best_estimate.push_back(header.fatx_best_estimate);
+  cv_weight.push_back(header.cv_weight);
+}
+
+void EventHeaderColumns::clear() {
+  present.clear();
+  event_number.clear();
+  process_id.clear();
+  lab_position.clear();
+  total_xsec.clear();
+  process_xsec.clear();
+  fatx_best_estimate.clear();
+  cv_weight.clear();
+}
+
+} // namespace NuHepMC
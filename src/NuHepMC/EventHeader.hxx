@@ -0,0 +1,109 @@
+#pragma once
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenRunInfo.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace NuHepMC {
+
+// The per-event NuHepMC metadata fields, decoded into plain values. Fields
+// that the event did not carry are zero and have their bit clear in present.
+struct EventHeader {
+  enum Field : uint32_t {
+    kProcessID = 1 << 0,        // E.R.3
+    kLabPosition = 1 << 1,      // E.R.5
+    kTotalXSec = 1 << 2,        // E.C.2
+    kProcessXSec = 1 << 3,      // E.C.3
+    kFATXBestEstimate = 1 << 4, // E.C.4
+    kCVWeight = 1 << 5,         // G.R.7
+  };
+
+  uint32_t present;
+
+  int event_number;
+  int process_id;
+  std::array<double, 4> lab_position;
+  double total_xsec;
+  double process_xsec;
+  double fatx_best_estimate;
+  double cv_weight;
+
+  bool has(Field f) const { return present & f; }
+};
+
+// Fills EventHeaders with one typed lookup per field. The position of the CV
+// weight is only looked up by name when the event's run info changes, so a
+// decoder should be re-used for every event in a file. A decoder is not
+// thread safe, give each thread its own.
+class EventHeaderDecoder {
+public:
+  EventHeaderDecoder() : cv_index(-1) {}
+
+  void decode(HepMC3::GenEvent const &evt, EventHeader &header);
+  EventHeader decode(HepMC3::GenEvent const &evt) {
+    EventHeader header;
+    decode(evt, header);
+    return header;
+  }
+
+  // -1 if the current run info has no CV weight
+  int cv_weight_index() const { return cv_index; }
+
+private:
+  std::shared_ptr<HepMC3::GenRunInfo const> run_info;
+  int cv_index;
+};
+
+// Columns of EventHeader fields for a batch of up to capacity events, for
+// code that would rather process a block of events field by field.
+class EventHeaderColumns {
+public:
+  explicit EventHeaderColumns(size_t capacity = 1024);
+
+  void push_back(EventHeader const &header);
+  void clear();
+
+  size_t size() const { return present.size(); }
+  size_t capacity() const { return cap; }
+  bool full() const { return size() >= cap; }
+
+  // Decodes events from rdr until the buffer is full or the reader fails,
+  // evt is used as scratch space. Returns the number of headers added.
+  template <typename Reader>
+  size_t fill(Reader &rdr, EventHeaderDecoder &decoder, HepMC3::GenEvent &evt);
+
+  std::vector<uint32_t> present;
+  std::vector<int> event_number;
+  std::vector<int> process_id;
+  std::vector<std::array<double, 4>> lab_position;
+  std::vector<double> total_xsec;
+  std::vector<double> process_xsec;
+  std::vector<double> fatx_best_estimate;
+  std::vector<double> cv_weight;
+
+private:
+  size_t cap;
+};
+
+template <typename Reader>
+size_t EventHeaderColumns::fill(Reader &rdr, EventHeaderDecoder &decoder,
+                                HepMC3::GenEvent &evt) {
+  size_t n = 0;
+  EventHeader header;
+  while (!full()) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    decoder.decode(evt, header);
+    push_back(header);
+    n++;
+  }
+  return n;
+}
+
+} // namespace NuHepMC
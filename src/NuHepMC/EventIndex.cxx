@@ -0,0 +1,420 @@
+#include "NuHepMC/EventIndex.hxx"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "HepMC3/ReaderAscii.h"
+#include "HepMC3/ReaderAsciiHepMC2.h"
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace NuHepMC {
+
+namespace {
+
+char const idx_magic[] = "NuHepMCIdx";
+uint32_t const idx_version = 1;
+
+// Finds the start of every event record in a stream that is fed to it in
+// arbitrarily sized chunks
+struct EventRecordScanner {
+  EventIndex &idx;
+  uint64_t pos;
+  bool line_start;
+  bool listing_ended;
+  std::string head;
+
+  EventRecordScanner(EventIndex &i)
+      : idx(i), pos(0), line_start(true), listing_ended(false) {}
+
+  void scan(char const *data, size_t n) {
+    if (head.size() < 256) {
+      head.append(data, std::min(n, 256 - head.size()));
+    }
+
+    char const *p = data;
+    char const *end = data + n;
+    while (!listing_ended && (p < end)) {
+      if (line_start) {
+        if (*p == 'E') {
+          idx.event_offsets.push_back(pos + uint64_t(p - data));
+        } else if ((*p == 'H') && idx.event_offsets.size()) {
+          // the end of event listing line
+          idx.end_offset = pos + uint64_t(p - data);
+          listing_ended = true;
+        }
+      }
+      auto nl = static_cast<char const *>(
+          std::memchr(p, '\n', size_t(end - p)));
+      line_start = bool(nl);
+      p = nl ? (nl + 1) : end;
+    }
+    pos += n;
+  }
+};
+
+void WriteVarint(std::ostream &os, uint64_t v) {
+  while (v >= 0x80) {
+    os.put(char((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  os.put(char(v));
+}
+
+uint64_t ReadVarint(std::istream &is) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = is.get();
+    if (c == std::char_traits<char>::eof()) {
+      throw EventIndex::InvalidIndexFile() << "Index file ended unexpectedly.";
+    }
+    v |= uint64_t(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return v;
+    }
+  }
+  throw EventIndex::InvalidIndexFile() << "Malformed integer in index file.";
+}
+
+// Opens filename and positions the returned stream at offset into the
+// decompressed byte stream
+std::shared_ptr<std::istream> OpenAt(std::string const &filename,
+                                     EventIndex const &idx, uint64_t offset) {
+  auto raw = std::make_shared<std::ifstream>(filename, std::ios::binary);
+  if (!raw->good()) {
+    throw EventIndex::NotIndexable() << "Failed to open " << filename;
+  }
+
+  if (idx.compression == Compression::Format::kNone) {
+    raw->seekg(std::streamoff(offset));
+    return raw;
+  }
+
+  // the last checkpoint at or before offset, the first is always (0, 0)
+  auto cp = std::upper_bound(
+      idx.checkpoints.begin(), idx.checkpoints.end(), offset,
+      [](uint64_t o, std::pair<uint64_t, uint64_t> const &c) {
+        return o < c.second;
+      });
+  --cp;
+
+  raw->seekg(std::streamoff(cp->first));
+  auto ds = std::make_shared<Compression::DecompressingIStream>(
+      raw, idx.compression);
+  ds->ignore(std::streamsize(offset - cp->second));
+  return ds;
+}
+
+// Serves the run header bytes, then at most nbytes from body
+class EventRangeStreamBuf : public std::streambuf {
+  std::string header;
+  std::shared_ptr<std::istream> body;
+  uint64_t remaining;
+  std::vector<char> buf;
+  bool header_done;
+
+protected:
+  int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+    if (!header_done) {
+      header_done = true;
+      if (header.size()) {
+        setg(&header[0], &header[0], &header[0] + header.size());
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+    if (!remaining) {
+      return traits_type::eof();
+    }
+    auto n = std::min(uint64_t(buf.size()), remaining);
+    body->read(buf.data(), std::streamsize(n));
+    auto got = uint64_t(body->gcount());
+    if (!got) {
+      remaining = 0;
+      return traits_type::eof();
+    }
+    remaining -= got;
+    setg(buf.data(), buf.data(), buf.data() + got);
+    return traits_type::to_int_type(*gptr());
+  }
+
+public:
+  EventRangeStreamBuf(std::string hdr, std::shared_ptr<std::istream> bdy,
+                      uint64_t nbytes)
+      : header(std::move(hdr)), body(bdy), remaining(nbytes), buf(1 << 18),
+        header_done(false) {}
+};
+
+class EventRangeIStream : public std::istream {
+  EventRangeStreamBuf buf;
+
+public:
+  EventRangeIStream(std::string hdr, std::shared_ptr<std::istream> bdy,
+                    uint64_t nbytes)
+      : std::istream(nullptr), buf(std::move(hdr), bdy, nbytes) {
+    rdbuf(&buf);
+  }
+};
+
+} // namespace
+
+EventIndex BuildEventIndex(std::string const &filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs.good()) {
+    throw EventIndex::NotIndexable() << "Failed to open " << filename;
+  }
+
+  EventIndex idx;
+  idx.format = EventIndex::Format::kAsciiv3;
+  idx.compression = Compression::DetectFormat(filename);
+  idx.file_size = std::filesystem::file_size(filename);
+  idx.header_size = 0;
+  idx.end_offset = 0;
+
+  EventRecordScanner scanner(idx);
+  std::vector<char> in_buf(1 << 20);
+
+  if (idx.compression == Compression::Format::kNone) {
+    while (ifs.read(in_buf.data(), std::streamsize(in_buf.size())),
+           ifs.gcount()) {
+      scanner.scan(in_buf.data(), size_t(ifs.gcount()));
+    }
+  } else {
+    auto decoder = Compression::MakeDecoder(idx.compression);
+    std::vector<char> out_buf(1 << 20);
+
+    idx.checkpoints.emplace_back(0, 0);
+
+    char const *in = in_buf.data();
+    size_t in_avail = 0;
+    uint64_t comp_read = 0;
+    bool member_ended = false;
+
+    while (true) {
+      bool eof = false;
+      if (!in_avail) {
+        ifs.read(in_buf.data(), std::streamsize(in_buf.size()));
+        in = in_buf.data();
+        in_avail = size_t(ifs.gcount());
+        comp_read += in_avail;
+        eof = !in_avail;
+      }
+
+      if (member_ended) {
+        // skip any zero-padding between members
+        while (in_avail && (*in == '\0')) {
+          in++;
+          in_avail--;
+        }
+        if (!in_avail) {
+          if (eof) {
+            break;
+          }
+          continue;
+        }
+        // decompression can start from scratch here
+        idx.checkpoints.emplace_back(comp_read - in_avail, scanner.pos);
+        decoder->reset();
+        member_ended = false;
+      }
+
+      char *out = out_buf.data();
+      size_t out_avail = out_buf.size();
+      member_ended = decoder->decode(in, in_avail, out, out_avail);
+      size_t produced = size_t(out - out_buf.data());
+      scanner.scan(out_buf.data(), produced);
+
+      if (eof && !produced) {
+        break;
+      }
+    }
+  }
+
+  if (scanner.head.rfind("HepMC::", 0) != 0) {
+    throw EventIndex::NotIndexable()
+        << "File " << filename
+        << " does not look like a HepMC3 or HepMC2 ASCII file, only ASCII "
+           "files can be indexed.";
+  }
+  if (scanner.head.find("IO_GenEvent") != std::string::npos) {
+    idx.format = EventIndex::Format::kAsciiHepMC2;
+  }
+
+  if (!scanner.listing_ended) {
+    idx.end_offset = scanner.pos;
+  }
+  idx.header_size = idx.size() ? idx.event_offsets.front() : idx.end_offset;
+
+  return idx;
+}
+
+void WriteEventIndex(EventIndex const &idx, std::string const &idx_filename) {
+  std::ofstream ofs(idx_filename, std::ios::binary);
+  if (!ofs.good()) {
+    throw EventIndex::InvalidIndexFile()
+        << "Failed to open " << idx_filename << " for writing.";
+  }
+
+  ofs.write(idx_magic, sizeof(idx_magic));
+  WriteVarint(ofs, idx_version);
+  WriteVarint(ofs, uint64_t(idx.format));
+  WriteVarint(ofs, uint64_t(idx.compression));
+  WriteVarint(ofs, idx.file_size);
+  WriteVarint(ofs, idx.header_size);
+  WriteVarint(ofs, idx.end_offset);
+
+  // offsets are monotonic, so deltas keep the sidecar to a couple of bytes
+  // per event
+  WriteVarint(ofs, idx.event_offsets.size());
+  uint64_t last = 0;
+  for (auto o : idx.event_offsets) {
+    WriteVarint(ofs, o - last);
+    last = o;
+  }
+
+  WriteVarint(ofs, idx.checkpoints.size());
+  std::pair<uint64_t, uint64_t> last_cp{0, 0};
+  for (auto const &cp : idx.checkpoints) {
+    WriteVarint(ofs, cp.first - last_cp.first);
+    WriteVarint(ofs, cp.second - last_cp.second);
+    last_cp = cp;
+  }
+
+  if (!ofs.good()) {
+    throw EventIndex::InvalidIndexFile()
+        << "Failed to write index to " << idx_filename;
+  }
+}
+
+EventIndex ReadEventIndex(std::string const &idx_filename) {
+  std::ifstream ifs(idx_filename, std::ios::binary);
+  char magic[sizeof(idx_magic)];
+  ifs.read(magic, sizeof(magic));
+  if ((ifs.gcount() != sizeof(magic)) ||
+      std::memcmp(magic, idx_magic, sizeof(magic))) {
+    throw EventIndex::InvalidIndexFile()
+        << idx_filename << " is not a NuHepMC event index file.";
+  }
+  auto version = ReadVarint(ifs);
+  if (version != idx_version) {
+    throw EventIndex::InvalidIndexFile()
+        << idx_filename << " has index format version " << version
+        << ", but this version of NuHepMC_CPPUtils reads version "
+        << idx_version;
+  }
+
+  EventIndex idx;
+  idx.format = EventIndex::Format(ReadVarint(ifs));
+  idx.compression = Compression::Format(ReadVarint(ifs));
+  idx.file_size = ReadVarint(ifs);
+  idx.header_size = ReadVarint(ifs);
+  idx.end_offset = ReadVarint(ifs);
+
+  idx.event_offsets.resize(ReadVarint(ifs));
+  uint64_t last = 0;
+  for (auto &o : idx.event_offsets) {
+    o = last + ReadVarint(ifs);
+    last = o;
+  }
+
+  idx.checkpoints.resize(ReadVarint(ifs));
+  std::pair<uint64_t, uint64_t> last_cp{0, 0};
+  for (auto &cp : idx.checkpoints) {
+    cp.first = last_cp.first + ReadVarint(ifs);
+    cp.second = last_cp.second + ReadVarint(ifs);
+    last_cp = cp;
+  }
+
+  return idx;
+}
+
+std::string EventIndexFilename(std::string const &filename) {
+  return filename + ".idx";
+}
+
+std::optional<EventIndex> LoadEventIndex(std::string const &filename) {
+  auto idx_filename = EventIndexFilename(filename);
+
+  std::error_code ec;
+  if (std::filesystem::exists(idx_filename, ec)) {
+    try {
+      auto idx = ReadEventIndex(idx_filename);
+      bool up_to_date =
+          (idx.file_size == std::filesystem::file_size(filename)) &&
+          (std::filesystem::last_write_time(idx_filename) >=
+           std::filesystem::last_write_time(filename));
+      if (up_to_date) {
+        return idx;
+      }
+    } catch (EventIndex::InvalidIndexFile const &) {
+      // treated as missing
+    }
+  }
+  return std::nullopt;
+}
+
+EventIndex LoadOrBuildEventIndex(std::string const &filename,
+                                 bool write_sidecar) {
+  auto loaded = LoadEventIndex(filename);
+  if (loaded) {
+    return *loaded;
+  }
+
+  auto idx_filename = EventIndexFilename(filename);
+  std::error_code ec;
+  auto idx = BuildEventIndex(filename);
+  if (write_sidecar) {
+    try {
+      WriteEventIndex(idx, idx_filename);
+    } catch (EventIndex::InvalidIndexFile const &) {
+      // the input may well live somewhere read-only, the index is just not
+      // cached in that case
+      std::filesystem::remove(idx_filename, ec);
+    }
+  }
+  return idx;
+}
+
+std::shared_ptr<std::istream> OpenEventRange(std::string const &filename,
+                                             EventIndex const &idx,
+                                             size_t begin, size_t end) {
+  if ((begin > end) || (end > idx.size())) {
+    throw EventIndex::EventRangeOutOfBounds()
+        << "Requested events [" << begin << ", " << end << ") from " << filename
+        << ", which only contains " << idx.size() << " events.";
+  }
+
+  std::string header(idx.header_size, '\0');
+  if (idx.header_size) {
+    auto hs = OpenAt(filename, idx, 0);
+    hs->read(&header[0], std::streamsize(idx.header_size));
+    if (uint64_t(hs->gcount()) != idx.header_size) {
+      throw EventIndex::NotIndexable()
+          << filename << " is shorter than its index, is the index stale?";
+    }
+  }
+
+  uint64_t start = (begin < idx.size()) ? idx.event_offsets[begin]
+                                        : idx.end_offset;
+  uint64_t stop = (end < idx.size()) ? idx.event_offsets[end] : idx.end_offset;
+
+  return std::make_shared<EventRangeIStream>(
+      std::move(header), OpenAt(filename, idx, start), stop - start);
+}
+
+std::shared_ptr<HepMC3::Reader> OpenEventRangeReader(
+    std::string const &filename, EventIndex const &idx, size_t begin,
+    size_t end) {
+  auto stream = OpenEventRange(filename, idx, begin, end);
+  if (idx.format == EventIndex::Format::kAsciiHepMC2) {
+    return std::make_shared<HepMC3::ReaderAsciiHepMC2>(stream);
+  }
+  return std::make_shared<HepMC3::ReaderAscii>(stream);
+}
+
+} // namespace NuHepMC
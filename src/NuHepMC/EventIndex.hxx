@@ -0,0 +1,78 @@
+#pragma once
+
+#include "NuHepMC/CompressedStreams.hxx"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "HepMC3/Reader.h"
+#pragma GCC diagnostic pop
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace NuHepMC {
+
+// The byte offset of every event record in a HepMC3 ASCII file, so that events
+// can be read from anywhere in the file without parsing everything in front of
+// them. For compressed files, all offsets are into the decompressed stream and
+// checkpoints record where decompression can be restarted from scratch.
+struct EventIndex {
+  NEW_NuHepMC_EXCEPT(NotIndexable);
+  NEW_NuHepMC_EXCEPT(InvalidIndexFile);
+  NEW_NuHepMC_EXCEPT(EventRangeOutOfBounds);
+
+  enum class Format { kAsciiv3 = 0, kAsciiHepMC2 = 1 };
+
+  Format format;
+  Compression::Format compression;
+
+  // size on disk of the indexed file, used to spot stale sidecars
+  uint64_t file_size;
+  // every byte before the first event record is run header
+  uint64_t header_size;
+  // the offset of the end of event listing line, or the stream size if the
+  // file was truncated
+  uint64_t end_offset;
+  std::vector<uint64_t> event_offsets;
+
+  // (compressed offset, decompressed offset) pairs at the start of each
+  // independently decompressible member, only filled for compressed files
+  std::vector<std::pair<uint64_t, uint64_t>> checkpoints;
+
+  size_t size() const { return event_offsets.size(); }
+};
+
+// Scans filename once, recording the offset of every event record
+EventIndex BuildEventIndex(std::string const &filename);
+
+void WriteEventIndex(EventIndex const &idx, std::string const &idx_filename);
+EventIndex ReadEventIndex(std::string const &idx_filename);
+
+// <filename>.idx
+std::string EventIndexFilename(std::string const &filename);
+
+// Reads the sidecar index for filename if it exists and matches the file
+std::optional<EventIndex> LoadEventIndex(std::string const &filename);
+
+// Reads the sidecar index for filename if it exists and matches the file,
+// otherwise builds the index and, if write_sidecar is set, tries to save it
+// next to the file for next time.
+EventIndex LoadOrBuildEventIndex(std::string const &filename,
+                                 bool write_sidecar = true);
+
+// Opens a stream made of the run header of filename followed by the
+// events [begin, end), every other event in the file is never touched.
+std::shared_ptr<std::istream> OpenEventRange(std::string const &filename,
+                                             EventIndex const &idx,
+                                             size_t begin, size_t end);
+
+// Opens a HepMC3 reader over the events [begin, end) of filename
+std::shared_ptr<HepMC3::Reader> OpenEventRangeReader(
+    std::string const &filename, EventIndex const &idx, size_t begin,
+    size_t end);
+
+} // namespace NuHepMC
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/Reader.hxx"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NuHepMC {
+
+struct EventLoopOptions {
+  // 0 uses one worker per hardware thread
+  size_t nthreads = 0;
+  // events are handed to workers in chunks of this size. Results only depend
+  // on the chunk size, not on the number of threads.
+  size_t chunk_size = 256;
+  // the maximum number of chunks read but not yet merged, 0 uses four per
+  // worker
+  size_t chunks_in_flight = 0;
+};
+
+// Reads events from a NuHepMC::Reader on the calling thread and fans them out,
+// in fixed-size chunks, to worker threads that pull the next available chunk
+// whenever they finish one, so uneven per-event costs do not leave workers
+// idle.
+//
+// Every chunk is processed with its own copy of the user state and its own
+// clone of the FATX accumulator, and the per-chunk results are merged in file
+// order, so the result is bit-for-bit the same whatever the number of threads.
+class EventLoop {
+  std::shared_ptr<NuHepMC::Reader> rdr;
+  EventLoopOptions opts;
+  size_t nevents;
+
+public:
+  NEW_NuHepMC_EXCEPT(NullReader);
+
+  EventLoop(std::shared_ptr<NuHepMC::Reader> reader,
+            EventLoopOptions options = EventLoopOptions())
+      : rdr(reader), opts(options), nevents(0) {
+    if (!rdr) {
+      throw NullReader() << "NuHepMC::EventLoop instantiated with a nullptr.";
+    }
+  }
+
+  // Calls func(HepMC3::GenEvent const &evt, double w, State &state) for every
+  // remaining event in the reader, where w is the CV weight returned by the
+  // accumulator, or 1 if no accumulator is passed. func is called
+  // concurrently from many threads, but never with the same state object.
+  //
+  // Each chunk starts from a copy of initial, and is combined into the result
+  // by merge(State &into, State const &chunk). The events seen by each chunk's
+  // accumulator are merged into acc.
+  template <typename State, typename Func, typename Merge>
+  State run(State const &initial, Func &&func, Merge &&merge,
+            std::shared_ptr<FATX::Accumulator> acc = nullptr);
+
+  // the number of events processed by the last call to run
+  size_t events() const { return nevents; }
+};
+
+template <typename State, typename Func, typename Merge>
+State EventLoop::run(State const &initial, Func &&func, Merge &&merge,
+                     std::shared_ptr<FATX::Accumulator> acc) {
+
+  size_t const nthreads =
+      opts.nthreads ? opts.nthreads
+                    : std::max(size_t(1),
+                               size_t(std::thread::hardware_concurrency()));
+  size_t const chunk_size = std::max(size_t(1), opts.chunk_size);
+  size_t const max_in_flight =
+      opts.chunks_in_flight ? opts.chunks_in_flight : (4 * nthreads);
+
+  struct Chunk {
+    size_t index;
+    size_t nevents;
+    std::vector<HepMC3::GenEvent> events;
+  };
+
+  struct Partial {
+    State state;
+    std::shared_ptr<FATX::Accumulator> acc;
+  };
+
+  std::mutex mtx;
+  std::condition_variable chunk_ready;
+  std::condition_variable slot_free;
+
+  std::deque<std::unique_ptr<Chunk>> queue;
+  // chunks whose events can be read into again
+  std::vector<std::unique_ptr<Chunk>> spare;
+  // partial results waiting for an earlier chunk to finish before merging
+  std::map<size_t, Partial> finished;
+  size_t nchunks_read = 0;
+  size_t nchunks_merged = 0;
+  bool reading_done = false;
+  bool abort = false;
+  std::exception_ptr error;
+
+  State result = initial;
+
+  auto fail = [&](std::exception_ptr e) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!error) {
+      error = e;
+    }
+    abort = true;
+  };
+
+  auto work = [&]() {
+    try {
+      while (true) {
+        std::unique_ptr<Chunk> chunk;
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          chunk_ready.wait(lock, [&] {
+            return abort || queue.size() || reading_done;
+          });
+          if (abort || !queue.size()) {
+            return;
+          }
+          chunk = std::move(queue.front());
+          queue.pop_front();
+        }
+
+        Partial part{initial, acc ? acc->clone() : nullptr};
+        for (size_t i = 0; i < chunk->nevents; ++i) {
+          auto const &evt = chunk->events[i];
+          double w = part.acc ? part.acc->process(evt) : 1;
+          func(evt, w, part.state);
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        finished.emplace(chunk->index, std::move(part));
+        spare.push_back(std::move(chunk));
+
+        // merge every contiguous finished chunk, in order
+        for (auto it = finished.find(nchunks_merged); it != finished.end();
+             it = finished.find(nchunks_merged)) {
+          merge(result, it->second.state);
+          if (acc) {
+            acc->merge(*it->second.acc);
+          }
+          finished.erase(it);
+          nchunks_merged++;
+        }
+        slot_free.notify_one();
+      }
+    } catch (...) {
+      fail(std::current_exception());
+      chunk_ready.notify_all();
+      slot_free.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < nthreads; ++i) {
+    workers.emplace_back(work);
+  }
+
+  nevents = 0;
+  try {
+    bool eof = false;
+    while (!eof) {
+      std::unique_ptr<Chunk> chunk;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        slot_free.wait(lock, [&] {
+          return abort || ((nchunks_read - nchunks_merged) < max_in_flight);
+        });
+        if (abort) {
+          break;
+        }
+        if (spare.size()) {
+          chunk = std::move(spare.back());
+          spare.pop_back();
+        }
+      }
+      if (!chunk) {
+        chunk = std::make_unique<Chunk>();
+        chunk->events.resize(chunk_size);
+      }
+
+      chunk->nevents = 0;
+      while (chunk->nevents < chunk_size) {
+        rdr->read_event(chunk->events[chunk->nevents]);
+        if (rdr->failed()) {
+          eof = true;
+          break;
+        }
+        chunk->nevents++;
+      }
+
+      if (!chunk->nevents) {
+        break;
+      }
+      nevents += chunk->nevents;
+
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        chunk->index = nchunks_read++;
+        queue.push_back(std::move(chunk));
+      }
+      chunk_ready.notify_one();
+    }
+  } catch (...) {
+    fail(std::current_exception());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    reading_done = true;
+  }
+  chunk_ready.notify_all();
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  return result;
+}
+
+} // namespace NuHepMC
@@ -0,0 +1,48 @@
+#include "NuHepMC/EventPool.hxx"
+
+namespace NuHepMC {
+
+std::unique_ptr<HepMC3::GenEvent> EventPool::acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (free_events.size()) {
+      auto evt = std::move(free_events.back());
+      free_events.pop_back();
+      nreused++;
+      return evt;
+    }
+    ncreated++;
+  }
+  return std::make_unique<HepMC3::GenEvent>();
+}
+
+void EventPool::release(std::unique_ptr<HepMC3::GenEvent> evt) {
+  if (!evt) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (free_events.size() < max_free) {
+      free_events.push_back(std::move(evt));
+      return;
+    }
+  }
+  // destroyed outside of the lock
+}
+
+size_t EventPool::size() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return free_events.size();
+}
+
+size_t EventPool::created() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return ncreated;
+}
+
+size_t EventPool::reused() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return nreused;
+}
+
+} // namespace NuHepMC
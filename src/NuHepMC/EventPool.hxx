@@ -0,0 +1,41 @@
+#pragma once
+
+#include "HepMC3/GenEvent.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace NuHepMC {
+
+// A thread-safe free list of GenEvents to be read into again. HepMC3 readers
+// clear an event before filling it, which keeps its particle, vertex, and
+// weight storage, so reading into a recycled event skips constructing the
+// event itself and regrowing those containers. Released events are not
+// cleared, so they hold on to their particles until they are next read into,
+// that cost falls on the reading thread rather than on the releasing one.
+class EventPool {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<HepMC3::GenEvent>> free_events;
+  size_t max_free;
+  size_t ncreated;
+  size_t nreused;
+
+public:
+  // at most max_free_events released events are held, any more are destroyed
+  explicit EventPool(size_t max_free_events = 64)
+      : max_free(max_free_events), ncreated(0), nreused(0) {}
+
+  // a released event if there is one, otherwise a new one
+  std::unique_ptr<HepMC3::GenEvent> acquire();
+  // evt may be nullptr
+  void release(std::unique_ptr<HepMC3::GenEvent> evt);
+
+  // the number of released events waiting to be acquired
+  size_t size();
+  // the number of events constructed by, and recycled through, acquire
+  size_t created();
+  size_t reused();
+};
+
+} // namespace NuHepMC
@@ -0,0 +1,354 @@
+#include "NuHepMC/EventStore.hxx"
+
+#include "NuHepMC/WriterUtils.hxx"
+
+#include "HepMC3/GenCrossSection.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NuHepMC {
+
+namespace {
+
+char const store_magic[] = "NuHepMCEvS";
+uint32_t const store_version = 1;
+// written as a native uint32 so that a store saved on a machine with a
+// different byte order is refused rather than misread
+uint32_t const store_byte_order = 0x01020304;
+
+// every column starts on a multiple of this many bytes into the file, which
+// mmap places on a page boundary
+constexpr size_t kColumnAlignment = 16;
+// magic, byte order, version, flags, momentum unit, and the four counts
+constexpr size_t kStoreHeaderSize = 64;
+
+constexpr uint32_t kHasMomenta = 1 << 0;
+
+size_t Aligned(size_t n) {
+  return ((n + kColumnAlignment - 1) / kColumnAlignment) * kColumnAlignment;
+}
+
+} // namespace
+
+template <typename Self, typename F>
+void EventStore::for_each_column(Self &self, Counts const &n, F &&f) {
+  f(self.part_offset, n.nevents + 1);
+  f(self.vtx_offset, n.nevents + 1);
+  f(self.weight_offset, n.nevents + 1);
+
+  f(self.present, n.nevents);
+  f(self.event_number, n.nevents);
+  f(self.process_id, n.nevents);
+  f(self.lab_position, n.nevents);
+  f(self.total_xsec, n.nevents);
+  f(self.process_xsec, n.nevents);
+  f(self.fatx_best_estimate, n.nevents);
+  f(self.cv_weight, n.nevents);
+
+  f(self.pid, n.nparticles);
+  f(self.status, n.nparticles);
+  f(self.prod_vtx, n.nparticles);
+  f(self.end_vtx, n.nparticles);
+  f(self.momenta, self.with_momenta ? n.nparticles : 0);
+
+  f(self.vtx_status, n.nvertices);
+
+  f(self.weights, n.nweights);
+}
+
+EventStore::EventStore(bool store_momenta,
+                       HepMC3::Units::MomentumUnit momentum_unit)
+    : with_momenta(store_momenta), unit(momentum_unit) {
+  part_offset.owned.push_back(0);
+  vtx_offset.owned.push_back(0);
+  weight_offset.owned.push_back(0);
+}
+
+EventStore::Counts EventStore::counts() const {
+  return Counts{size(), nparticles(), nvertices(), weights.size()};
+}
+
+size_t EventStore::bytes() const {
+  size_t nbytes = 0;
+  for_each_column(*this, counts(), [&](auto const &col, size_t) {
+    nbytes += col.size() * sizeof(col[0]);
+  });
+  return nbytes;
+}
+
+size_t EventStore::add(HepMC3::GenEvent const &evt) {
+  if (mapping) {
+    for_each_column(*this, counts(), [](auto &col, size_t) { col.thaw(); });
+    mapping.reset();
+  }
+
+  EventHeader hdr;
+  decoder.decode(evt, hdr);
+  present.owned.push_back(hdr.present);
+  event_number.owned.push_back(hdr.event_number);
+  process_id.owned.push_back(hdr.process_id);
+  lab_position.owned.push_back(hdr.lab_position);
+  total_xsec.owned.push_back(hdr.total_xsec);
+  process_xsec.owned.push_back(hdr.process_xsec);
+  fatx_best_estimate.owned.push_back(hdr.fatx_best_estimate);
+  cv_weight.owned.push_back(hdr.cv_weight);
+
+  double const scale = (evt.momentum_unit() == unit)
+                           ? 1
+                           : ((unit == HepMC3::Units::GEV) ? 1E-3 : 1E3);
+
+  size_t const first_part = pid.size();
+  for (auto const &part : evt.particles()) {
+    pid.owned.push_back(part->pid());
+    status.owned.push_back(part->status());
+    prod_vtx.owned.push_back(-1);
+    end_vtx.owned.push_back(-1);
+    if (with_momenta) {
+      auto const &mom = part->momentum();
+      momenta.owned.push_back(
+          {float(mom.px() * scale), float(mom.py() * scale),
+           float(mom.pz() * scale), float(mom.e() * scale)});
+    }
+  }
+
+  // particle ids are their 1-based positions in the event
+  auto const &vtxs = evt.vertices();
+  for (size_t j = 0; j < vtxs.size(); ++j) {
+    vtx_status.owned.push_back(vtxs[j]->status());
+    for (auto const &part : vtxs[j]->particles_in()) {
+      end_vtx.owned[first_part + size_t(part->id() - 1)] = int32_t(j);
+    }
+    for (auto const &part : vtxs[j]->particles_out()) {
+      prod_vtx.owned[first_part + size_t(part->id() - 1)] = int32_t(j);
+    }
+  }
+
+  weights.owned.insert(weights.owned.end(), evt.weights().begin(),
+                       evt.weights().end());
+
+  part_offset.owned.push_back(pid.size());
+  vtx_offset.owned.push_back(vtx_status.size());
+  weight_offset.owned.push_back(weights.size());
+
+  return size() - 1;
+}
+
+EventStore::EventView EventStore::event(size_t i) const {
+  size_t const p0 = part_offset[i];
+  size_t const v0 = vtx_offset[i];
+  size_t const w0 = weight_offset[i];
+
+  EventView view;
+  view.nparticles = part_offset[i + 1] - p0;
+  view.pid = pid.data() + p0;
+  view.status = status.data() + p0;
+  view.prod_vtx = prod_vtx.data() + p0;
+  view.end_vtx = end_vtx.data() + p0;
+  view.momenta = with_momenta ? (momenta.data() + p0) : nullptr;
+  view.nvertices = vtx_offset[i + 1] - v0;
+  view.vtx_status = vtx_status.data() + v0;
+  view.nweights = weight_offset[i + 1] - w0;
+  view.weights = weights.data() + w0;
+  return view;
+}
+
+EventHeader EventStore::header(size_t i) const {
+  EventHeader hdr;
+  hdr.present = present[i];
+  hdr.event_number = event_number[i];
+  hdr.process_id = process_id[i];
+  hdr.lab_position = lab_position[i];
+  hdr.total_xsec = total_xsec[i];
+  hdr.process_xsec = process_xsec[i];
+  hdr.fatx_best_estimate = fatx_best_estimate[i];
+  hdr.cv_weight = cv_weight[i];
+  return hdr;
+}
+
+void EventStore::rebuild(size_t i, HepMC3::GenEvent &evt) const {
+  auto const view = event(i);
+  auto const hdr = header(i);
+
+  evt.clear();
+  evt.set_units(unit, HepMC3::Units::MM);
+  evt.set_event_number(hdr.event_number);
+  evt.weights().assign(view.weights, view.weights + view.nweights);
+
+  std::vector<HepMC3::GenVertexPtr> vtxs(view.nvertices);
+  for (size_t j = 0; j < view.nvertices; ++j) {
+    vtxs[j] = std::make_shared<HepMC3::GenVertex>();
+    vtxs[j]->set_status(view.vtx_status[j]);
+    evt.add_vertex(vtxs[j]);
+  }
+
+  // particles are added to the event before they are attached to their
+  // vertices so that they keep their positions
+  for (size_t k = 0; k < view.nparticles; ++k) {
+    auto part = std::make_shared<HepMC3::GenParticle>(
+        view.momentum(k), view.pid[k], view.status[k]);
+    evt.add_particle(part);
+    if (view.prod_vtx[k] >= 0) {
+      vtxs[size_t(view.prod_vtx[k])]->add_particle_out(part);
+    }
+    if (view.end_vtx[k] >= 0) {
+      vtxs[size_t(view.end_vtx[k])]->add_particle_in(part);
+    }
+  }
+
+  if (hdr.has(EventHeader::kProcessID)) {
+    ER3::SetProcessID(evt, hdr.process_id);
+  }
+  if (hdr.has(EventHeader::kLabPosition)) {
+    ER5::SetLabPosition(evt, std::vector<double>(hdr.lab_position.begin(),
+                                                 hdr.lab_position.end()));
+  }
+  if (hdr.has(EventHeader::kTotalXSec)) {
+    EC2::SetTotalCrossSection(evt, hdr.total_xsec);
+  }
+  if (hdr.has(EventHeader::kProcessXSec)) {
+    EC3::SetProcessCrossSection(evt, hdr.process_xsec);
+  }
+  if (hdr.has(EventHeader::kFATXBestEstimate)) {
+    // only the CV estimate is kept, so it stands in for every weight
+    size_t const nxsecs = std::max(view.nweights, size_t(1));
+    auto xs = std::make_shared<HepMC3::GenCrossSection>();
+    evt.set_cross_section(xs);
+    xs->set_cross_section(std::vector<double>(nxsecs, hdr.fatx_best_estimate),
+                          std::vector<double>(nxsecs, 0));
+  }
+}
+
+void EventStore::save(std::string const &filename) const {
+  std::ofstream ofs(filename, std::ios::binary);
+  if (!ofs.good()) {
+    throw InvalidStoreFile()
+        << "Failed to open " << filename << " for writing.";
+  }
+
+  auto const n = counts();
+  uint32_t const flags = with_momenta ? kHasMomenta : 0;
+  uint32_t const momentum_unit = uint32_t(unit);
+
+  char head[kStoreHeaderSize] = {};
+  char *h = head;
+  auto put = [&](void const *data, size_t nbytes) {
+    std::memcpy(h, data, nbytes);
+    h += nbytes;
+  };
+  put(store_magic, sizeof(store_magic));
+  h = head + 16;
+  put(&store_byte_order, sizeof(store_byte_order));
+  put(&store_version, sizeof(store_version));
+  put(&flags, sizeof(flags));
+  put(&momentum_unit, sizeof(momentum_unit));
+  put(&n.nevents, sizeof(n.nevents));
+  put(&n.nparticles, sizeof(n.nparticles));
+  put(&n.nvertices, sizeof(n.nvertices));
+  put(&n.nweights, sizeof(n.nweights));
+  ofs.write(head, sizeof(head));
+
+  char const padding[kColumnAlignment] = {};
+  for_each_column(*this, n, [&](auto const &col, size_t) {
+    size_t const nbytes = col.size() * sizeof(col[0]);
+    ofs.write(reinterpret_cast<char const *>(col.data()),
+              std::streamsize(nbytes));
+    ofs.write(padding, std::streamsize(Aligned(nbytes) - nbytes));
+  });
+
+  if (!ofs.good()) {
+    throw InvalidStoreFile() << "Failed to write event store to " << filename;
+  }
+}
+
+EventStore EventStore::load(std::string const &filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw InvalidStoreFile() << "Failed to open " << filename;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) || (size_t(st.st_size) < kStoreHeaderSize)) {
+    ::close(fd);
+    throw InvalidStoreFile()
+        << filename << " is too small to be a NuHepMC event store.";
+  }
+  size_t const file_size = size_t(st.st_size);
+  void *addr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping holds its own reference to the file
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    throw InvalidStoreFile() << "Failed to map " << filename;
+  }
+
+  EventStore store;
+  store.mapping = std::shared_ptr<char const>(
+      static_cast<char const *>(addr), [file_size](char const *p) {
+        ::munmap(const_cast<char *>(p), file_size);
+      });
+  char const *base = store.mapping.get();
+
+  char const *h = base;
+  auto get = [&](void *data, size_t nbytes) {
+    std::memcpy(data, h, nbytes);
+    h += nbytes;
+  };
+
+  if (std::memcmp(base, store_magic, sizeof(store_magic))) {
+    throw InvalidStoreFile()
+        << filename << " is not a NuHepMC event store file.";
+  }
+  h = base + 16;
+  uint32_t byte_order, version, flags, momentum_unit;
+  get(&byte_order, sizeof(byte_order));
+  get(&version, sizeof(version));
+  if (byte_order != store_byte_order) {
+    throw InvalidStoreFile()
+        << filename << " was saved on a machine with a different byte order.";
+  }
+  if (version != store_version) {
+    throw InvalidStoreFile()
+        << filename << " has event store format version " << version
+        << ", but this version of NuHepMC_CPPUtils reads version "
+        << store_version;
+  }
+  get(&flags, sizeof(flags));
+  get(&momentum_unit, sizeof(momentum_unit));
+  Counts n;
+  get(&n.nevents, sizeof(n.nevents));
+  get(&n.nparticles, sizeof(n.nparticles));
+  get(&n.nvertices, sizeof(n.nvertices));
+  get(&n.nweights, sizeof(n.nweights));
+
+  store.with_momenta = flags & kHasMomenta;
+  store.unit = HepMC3::Units::MomentumUnit(momentum_unit);
+
+  size_t offset = kStoreHeaderSize;
+  for_each_column(store, n, [&](auto &col, size_t nentries) {
+    size_t const nbytes = nentries * sizeof(col[0]);
+    if ((offset + nbytes) > file_size) {
+      throw InvalidStoreFile() << filename << " is truncated.";
+    }
+    col.owned.clear();
+    col.mapped = reinterpret_cast<decltype(col.mapped)>(base + offset);
+    col.mapped_size = nentries;
+    offset += Aligned(nbytes);
+  });
+
+  if ((store.part_offset[n.nevents] != n.nparticles) ||
+      (store.vtx_offset[n.nevents] != n.nvertices) ||
+      (store.weight_offset[n.nevents] != n.nweights)) {
+    throw InvalidStoreFile() << filename << " is corrupt.";
+  }
+
+  return store;
+}
+
+} // namespace NuHepMC
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "NuHepMC/EventHeader.hxx"
+#include "NuHepMC/Exceptions.hxx"
+
+#include "HepMC3/FourVector.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/Units.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NuHepMC {
+
+// A compact copy of many events packed into contiguous columns, for analyses
+// that loop over the same selected events many times. For each event it keeps
+// the EventHeader fields, the weights, every particle's PDG code and status,
+// optionally its four-momentum as floats, and the vertex graph as the
+// positions of each particle's production and end vertices. Particle i of a
+// stored event is evt.particles()[i] and vertex j is evt.vertices()[j], as in
+// FlatEvent. Vertex positions and any other attributes are not kept.
+//
+// A saved store is laid out as it is in memory, so load maps the file rather
+// than reading it, and only the pages of the events that are looked at are
+// ever read from disk.
+class EventStore {
+public:
+  NEW_NuHepMC_EXCEPT(InvalidStoreFile);
+
+  // The arrays of a single stored event, valid until the store is next added
+  // to or destroyed. Momenta are in the momentum_unit of the store.
+  struct EventView {
+    size_t nparticles;
+    int32_t const *pid;
+    int32_t const *status;
+    // positions into the vertex arrays, -1 if the particle has no such vertex
+    int32_t const *prod_vtx;
+    int32_t const *end_vtx;
+    // px, py, pz, e for each particle, nullptr if momenta are not stored
+    std::array<float, 4> const *momenta;
+
+    size_t nvertices;
+    int32_t const *vtx_status;
+
+    size_t nweights;
+    double const *weights;
+
+    HepMC3::FourVector momentum(size_t i) const {
+      if (!momenta) {
+        return HepMC3::FourVector::ZERO_VECTOR();
+      }
+      auto const &p = momenta[i];
+      return HepMC3::FourVector(p[0], p[1], p[2], p[3]);
+    }
+  };
+
+  explicit EventStore(
+      bool store_momenta = true,
+      HepMC3::Units::MomentumUnit momentum_unit = HepMC3::Units::MEV);
+
+  // Appends a copy of evt, converting its momenta to momentum_unit(), and
+  // returns its position in the store
+  size_t add(HepMC3::GenEvent const &evt);
+
+  size_t size() const { return event_number.size(); }
+  size_t nparticles() const { return pid.size(); }
+  size_t nvertices() const { return vtx_status.size(); }
+  bool has_momenta() const { return with_momenta; }
+  HepMC3::Units::MomentumUnit momentum_unit() const { return unit; }
+  // the size of the stored columns
+  size_t bytes() const;
+
+  EventView event(size_t i) const;
+  EventHeader header(size_t i) const;
+
+  // Rebuilds stored event i into evt, which keeps its run info. The vertex
+  // graph, weights, and the EventHeader fields as NuHepMC attributes are
+  // restored, and the momenta if they were stored. Only the CV FATX best
+  // estimate is kept, and it is restored as the cross section of every weight.
+  void rebuild(size_t i, HepMC3::GenEvent &evt) const;
+
+  // Saves the store in the byte order of this machine
+  void save(std::string const &filename) const;
+  // Maps a saved store read-only. Adding to a loaded store first copies it
+  // into memory.
+  static EventStore load(std::string const &filename);
+
+private:
+  // a column either held in memory or pointing into a mapped file
+  template <typename T> struct Column {
+    std::vector<T> owned;
+    T const *mapped = nullptr;
+    size_t mapped_size = 0;
+
+    T const *data() const { return mapped ? mapped : owned.data(); }
+    size_t size() const { return mapped ? mapped_size : owned.size(); }
+    T const &operator[](size_t i) const { return data()[i]; }
+
+    void thaw() {
+      if (mapped) {
+        owned.assign(mapped, mapped + mapped_size);
+        mapped = nullptr;
+        mapped_size = 0;
+      }
+    }
+  };
+
+  struct Counts {
+    uint64_t nevents;
+    uint64_t nparticles;
+    uint64_t nvertices;
+    uint64_t nweights;
+  };
+  Counts counts() const;
+
+  // calls f(column, n) on every column of self in the order that they are
+  // saved, where n is the number of entries the column has for counts
+  template <typename Self, typename F>
+  static void for_each_column(Self &self, Counts const &n, F &&f);
+
+  bool with_momenta;
+  HepMC3::Units::MomentumUnit unit;
+
+  // the position of the first particle, vertex, and weight of each event,
+  // with one more entry for the end of the last event
+  Column<uint64_t> part_offset;
+  Column<uint64_t> vtx_offset;
+  Column<uint64_t> weight_offset;
+
+  // EventHeader fields
+  Column<uint32_t> present;
+  Column<int32_t> event_number;
+  Column<int32_t> process_id;
+  Column<std::array<double, 4>> lab_position;
+  Column<double> total_xsec;
+  Column<double> process_xsec;
+  Column<double> fatx_best_estimate;
+  Column<double> cv_weight;
+
+  Column<int32_t> pid;
+  Column<int32_t> status;
+  Column<int32_t> prod_vtx;
+  Column<int32_t> end_vtx;
+  Column<std::array<float, 4>> momenta;
+
+  Column<int32_t> vtx_status;
+
+  Column<double> weights;
+
+  // keeps the mapped file of a loaded store alive
+  std::shared_ptr<char const> mapping;
+
+  EventHeaderDecoder decoder;
+};
+
+} // namespace NuHepMC
@@ -5,14 +5,184 @@
 #include "HepMC3/GenParticle.h"
 #include "HepMC3/Print.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace NuHepMC {
 
+namespace {
+
+bool InPDGs(std::vector<int> const &PDGs, int pid) {
+  return !PDGs.size() ||
+         (std::find(PDGs.begin(), PDGs.end(), pid) != PDGs.end());
+}
+
+double P3Mod2(HepMC3::GenParticle const &part) {
+  return part.momentum().p3mod2();
+}
+double Energy(HepMC3::GenParticle const &part) { return part.momentum().e(); }
+
+// single-pass arg-max of key over the particles with part_status whose PDG
+// code passes match, the first in order wins ties
+template <typename Match, typename Key>
+HepMC3::ConstGenParticlePtr const *
+ArgMax(std::vector<HepMC3::ConstGenParticlePtr> const &parts, int part_status,
+       Match const &match, Key const &key) {
+  HepMC3::ConstGenParticlePtr const *best = nullptr;
+  double best_key = 0;
+  for (auto const &part : parts) {
+    if ((part_status && (part->status() != part_status)) ||
+        !match(part->pid())) {
+      continue;
+    }
+    double k = key(*part);
+    if (!best || (k > best_key)) {
+      best = &part;
+      best_key = k;
+    }
+  }
+  return best;
+}
+
+template <typename Key>
+HepMC3::ConstGenParticlePtr
+ArgMax(std::vector<HepMC3::ConstGenParticlePtr> const &parts, int part_status,
+       std::vector<int> const &PDGs, Key const &key) {
+  auto best = ArgMax(
+      parts, part_status, [&](int pid) { return InPDGs(PDGs, pid); }, key);
+  return best ? *best : nullptr;
+}
+
+template <typename Key>
+HepMC3::GenParticle const *
+ArgMax(std::vector<HepMC3::ConstGenParticlePtr> const &parts, int part_status,
+       PDGSet const &PDGs, Key const &key) {
+  auto best = ArgMax(
+      parts, part_status, [&](int pid) { return PDGs.contains(pid); }, key);
+  return best ? best->get() : nullptr;
+}
+
+} // namespace
+
 namespace Event {
 
 NEW_NuHepMC_EXCEPT(NoTargetParticle);
 
+void Index::build(HepMC3::GenEvent const &event) {
+  evt = &event;
+
+  auto const &parts = event.particles();
+  int const nparts = int(parts.size());
+
+  status.resize(nparts);
+  pid.resize(nparts);
+  all.resize(nparts);
+  beam_part = nullptr;
+  target_part = nullptr;
+
+  for (int i = 0; i < nparts; ++i) {
+    status[i] = parts[i]->status();
+    pid[i] = parts[i]->pid();
+    all[i] = i;
+
+    if (!beam_part && (status[i] == ParticleStatus::IncomingBeam)) {
+      beam_part = parts[i];
+    } else if (!target_part && (status[i] == ParticleStatus::Target)) {
+      target_part = parts[i];
+    }
+  }
+
+  // position is the final tie-break so that every bucket is in event order,
+  // std::sort rather than std::stable_sort avoids a temporary allocation
+  by_status = all;
+  std::sort(by_status.begin(), by_status.end(), [this](int l, int r) {
+    return (status[l] != status[r]) ? (status[l] < status[r]) : (l < r);
+  });
+
+  by_pid = all;
+  std::sort(by_pid.begin(), by_pid.end(), [this](int l, int r) {
+    return (pid[l] != pid[r]) ? (pid[l] < pid[r]) : (l < r);
+  });
+
+  by_status_pid = by_status;
+  std::sort(by_status_pid.begin(), by_status_pid.end(), [this](int l, int r) {
+    if (status[l] != status[r]) {
+      return status[l] < status[r];
+    }
+    return (pid[l] != pid[r]) ? (pid[l] < pid[r]) : (l < r);
+  });
+
+  first_vtx.clear();
+  auto const &vtxs = event.vertices();
+  for (int i = 0; i < int(vtxs.size()); ++i) {
+    int vtx_status = vtxs[i]->status();
+    if (std::find_if(first_vtx.begin(), first_vtx.end(),
+                     [=](std::pair<int, int> const &fv) {
+                       return fv.first == vtx_status;
+                     }) == first_vtx.end()) {
+      first_vtx.emplace_back(vtx_status, i);
+    }
+  }
+  std::sort(first_vtx.begin(), first_vtx.end());
+
+  primary_vtx = first_vertex(VertexStatus::Primary);
+}
+
+Index::Range Index::with_status(int part_status) const {
+  if (!part_status) {
+    return {all.data(), all.data() + all.size()};
+  }
+  auto lb = std::lower_bound(
+      by_status.begin(), by_status.end(), part_status,
+      [this](int pos, int st) { return status[pos] < st; });
+  auto ub = std::upper_bound(
+      lb, by_status.end(), part_status,
+      [this](int st, int pos) { return st < status[pos]; });
+  return {by_status.data() + (lb - by_status.begin()),
+          by_status.data() + (ub - by_status.begin())};
+}
+
+Index::Range Index::with_pid(int part_pid) const {
+  auto lb = std::lower_bound(by_pid.begin(), by_pid.end(), part_pid,
+                             [this](int pos, int p) { return pid[pos] < p; });
+  auto ub = std::upper_bound(lb, by_pid.end(), part_pid,
+                             [this](int p, int pos) { return p < pid[pos]; });
+  return {by_pid.data() + (lb - by_pid.begin()),
+          by_pid.data() + (ub - by_pid.begin())};
+}
+
+Index::Range Index::with_status_and_pid(int part_status, int part_pid) const {
+  if (!part_status) {
+    return with_pid(part_pid);
+  }
+  std::pair<int, int> key{part_status, part_pid};
+  auto lb = std::lower_bound(
+      by_status_pid.begin(), by_status_pid.end(), key,
+      [this](int pos, std::pair<int, int> const &k) {
+        return std::make_pair(status[pos], pid[pos]) < k;
+      });
+  auto ub = std::upper_bound(
+      lb, by_status_pid.end(), key,
+      [this](std::pair<int, int> const &k, int pos) {
+        return k < std::make_pair(status[pos], pid[pos]);
+      });
+  return {by_status_pid.data() + (lb - by_status_pid.begin()),
+          by_status_pid.data() + (ub - by_status_pid.begin())};
+}
+
+HepMC3::ConstGenVertexPtr Index::first_vertex(int vtx_status) const {
+  auto const &vtxs = evt->vertices();
+  if (!vtx_status) {
+    return vtxs.size() ? vtxs.front() : nullptr;
+  }
+  auto fv = std::lower_bound(first_vtx.begin(), first_vtx.end(),
+                             std::make_pair(vtx_status, 0));
+  if ((fv == first_vtx.end()) || (fv->first != vtx_status)) {
+    return nullptr;
+  }
+  return vtxs[fv->second];
+}
+
 HepMC3::ConstGenVertexPtr GetVertex_First(HepMC3::GenEvent const &evt,
                                           int vtx_status) {
   for (auto const &vtx : evt.vertices()) {
@@ -35,8 +205,9 @@ HepMC3::ConstGenParticlePtr GetTargetParticle(HepMC3::GenEvent const &evt) {
   return GetParticle_First(evt, ParticleStatus::Target);
 }
 
-int GetTargetPDG(HepMC3::GenEvent const &evt) {
-  auto tgt_part = NuHepMC::Event::GetTargetParticle(evt);
+namespace {
+int TargetPDG(HepMC3::ConstGenParticlePtr const &tgt_part,
+              HepMC3::GenEvent const &evt) {
   if (!tgt_part) {
     HepMC3::Print::listing(evt);
     throw NoTargetParticle()
@@ -54,10 +225,15 @@ int GetTargetPDG(HepMC3::GenEvent const &evt) {
 
   return tgt_part_id;
 }
+} // namespace
+
+int GetTargetPDG(HepMC3::GenEvent const &evt) {
+  return TargetPDG(GetTargetParticle(evt), evt);
+}
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticles_All(HepMC3::GenEvent const &evt, int part_status,
-                 std::vector<int> PDGs) {
+                 std::vector<int> const &PDGs) {
 
   std::vector<HepMC3::ConstGenParticlePtr> parts;
 
@@ -77,13 +253,13 @@ GetParticles_All(HepMC3::GenEvent const &evt, int part_status,
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticles_AllRealFinalState(HepMC3::GenEvent const &evt,
-                               std::vector<int> PDGs) {
+                               std::vector<int> const &PDGs) {
   return GetParticles_All(evt, ParticleStatus::UndecayedPhysical, PDGs);
 }
 
 HepMC3::ConstGenParticlePtr GetParticle_First(HepMC3::GenEvent const &evt,
                                               int part_status,
-                                              std::vector<int> PDGs) {
+                                              std::vector<int> const &PDGs) {
   for (auto const &part : evt.particles()) {
     if (!part_status || (part->status() == part_status)) {
       if (PDGs.size()) {
@@ -100,37 +276,170 @@ HepMC3::ConstGenParticlePtr GetParticle_First(HepMC3::GenEvent const &evt,
 
 HepMC3::ConstGenParticlePtr
 GetParticle_FirstRealFinalState(HepMC3::GenEvent const &evt,
-                                std::vector<int> PDGs) {
+                                std::vector<int> const &PDGs) {
   return GetParticle_First(evt, ParticleStatus::UndecayedPhysical, PDGs);
 }
 
 HepMC3::ConstGenParticlePtr
 GetParticle_HighestMomentum(HepMC3::GenEvent const &evt, int part_status,
-                            std::vector<int> PDGs) {
+                            std::vector<int> const &PDGs) {
 
-  auto parts = GetParticles_All(evt, part_status, PDGs);
-  if (!parts.size()) {
-    return nullptr;
+  return ArgMax(evt.particles(), part_status, PDGs, P3Mod2);
+}
+
+HepMC3::ConstGenParticlePtr
+GetParticle_HighestMomentumRealFinalState(HepMC3::GenEvent const &evt,
+                                          std::vector<int> const &PDGs) {
+  return GetParticle_HighestMomentum(evt, ParticleStatus::UndecayedPhysical,
+                                     PDGs);
+}
+
+// calls f with the Index::Range of particles matching part_status for each
+// requested PDG code, or all of them if PDGs is empty
+template <typename F>
+void ForEachRange(Index const &idx, int part_status,
+                  std::vector<int> const &PDGs, F &&f) {
+  if (!PDGs.size()) {
+    f(idx.with_status(part_status));
+    return;
+  }
+  for (auto pdg : PDGs) {
+    f(idx.with_status_and_pid(part_status, pdg));
   }
+}
 
-  std::sort(parts.begin(), parts.end(),
-            [](HepMC3::ConstGenParticlePtr &l,
-               HepMC3::ConstGenParticlePtr &r) -> bool {
-              return l->momentum().p3mod2() < r->momentum().p3mod2();
-            });
+HepMC3::ConstGenVertexPtr GetVertex_First(Index const &idx, int vtx_status) {
+  return idx.first_vertex(vtx_status);
+}
+
+HepMC3::ConstGenVertexPtr GetPrimaryVertex(Index const &idx) {
+  return idx.primary_vertex();
+}
+
+HepMC3::ConstGenParticlePtr GetBeamParticle(Index const &idx) {
+  return idx.beam();
+}
+
+HepMC3::ConstGenParticlePtr GetTargetParticle(Index const &idx) {
+  return idx.target();
+}
+
+int GetTargetPDG(Index const &idx) {
+  return TargetPDG(idx.target(), idx.event());
+}
+
+std::vector<HepMC3::ConstGenParticlePtr>
+GetParticles_All(Index const &idx, int part_status,
+                 std::vector<int> const &PDGs) {
+  std::vector<int> positions;
+  ForEachRange(idx, part_status, PDGs, [&](Index::Range const &r) {
+    positions.insert(positions.end(), r.begin(), r.end());
+  });
+
+  // particles matching different PDGs have to be put back in event order
+  if (PDGs.size() > 1) {
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+                    positions.end());
+  }
+
+  std::vector<HepMC3::ConstGenParticlePtr> parts;
+  parts.reserve(positions.size());
+  for (auto pos : positions) {
+    parts.push_back(idx.particles()[pos]);
+  }
+  return parts;
+}
+
+std::vector<HepMC3::ConstGenParticlePtr>
+GetParticles_AllRealFinalState(Index const &idx, std::vector<int> const &PDGs) {
+  return GetParticles_All(idx, ParticleStatus::UndecayedPhysical, PDGs);
+}
+
+HepMC3::ConstGenParticlePtr GetParticle_First(Index const &idx,
+                                              int part_status,
+                                              std::vector<int> const &PDGs) {
+  int first = -1;
+  ForEachRange(idx, part_status, PDGs, [&](Index::Range const &r) {
+    if (r.size() && ((first == -1) || (*r.begin() < first))) {
+      first = *r.begin();
+    }
+  });
+  return (first == -1) ? nullptr : idx.particles()[first];
+}
 
-  return parts.back();
+HepMC3::ConstGenParticlePtr
+GetParticle_FirstRealFinalState(Index const &idx,
+                                std::vector<int> const &PDGs) {
+  return GetParticle_First(idx, ParticleStatus::UndecayedPhysical, PDGs);
 }
 
 HepMC3::ConstGenParticlePtr
-GetParticle_HighestMomentumRealFinalState(HepMC3::GenEvent const &evt,
-                                          std::vector<int> PDGs) {
-  return GetParticle_HighestMomentum(evt, ParticleStatus::UndecayedPhysical,
+GetParticle_HighestMomentum(Index const &idx, int part_status,
+                            std::vector<int> const &PDGs) {
+  int best = -1;
+  double best_p3mod2 = 0;
+  ForEachRange(idx, part_status, PDGs, [&](Index::Range const &r) {
+    for (auto pos : r) {
+      double p3mod2 = idx.particles()[pos]->momentum().p3mod2();
+      if ((best == -1) || (p3mod2 > best_p3mod2) ||
+          ((p3mod2 == best_p3mod2) && (pos < best))) {
+        best = pos;
+        best_p3mod2 = p3mod2;
+      }
+    }
+  });
+  return (best == -1) ? nullptr : idx.particles()[best];
+}
+
+HepMC3::ConstGenParticlePtr
+GetParticle_HighestMomentumRealFinalState(Index const &idx,
+                                          std::vector<int> const &PDGs) {
+  return GetParticle_HighestMomentum(idx, ParticleStatus::UndecayedPhysical,
                                      PDGs);
 }
 
+size_t SelectParticles(HepMC3::GenEvent const &evt, int part_status,
+                       PDGSet const &PDGs,
+                       std::vector<HepMC3::GenParticle const *> &out) {
+  out.clear();
+  VisitParticles(evt, part_status, PDGs,
+                 [&](HepMC3::ConstGenParticlePtr const &part) {
+                   out.push_back(part.get());
+                 });
+  return out.size();
+}
+
+HepMC3::GenParticle const *FindParticle_First(HepMC3::GenEvent const &evt,
+                                              int part_status,
+                                              PDGSet const &PDGs) {
+  for (auto const &part : evt.particles()) {
+    if ((!part_status || (part->status() == part_status)) &&
+        PDGs.contains(part->pid())) {
+      return part.get();
+    }
+  }
+  return nullptr;
+}
+
+HepMC3::GenParticle const *
+FindParticle_HighestMomentum(HepMC3::GenEvent const &evt, int part_status,
+                             PDGSet const &PDGs) {
+  return ArgMax(evt.particles(), part_status, PDGs, P3Mod2);
+}
+
+HepMC3::GenParticle const *
+FindParticle_HighestEnergy(HepMC3::GenEvent const &evt, int part_status,
+                           PDGSet const &PDGs) {
+  return ArgMax(evt.particles(), part_status, PDGs, Energy);
+}
+
 double ToMeVFactor(HepMC3::GenEvent const &evt) {
-  return (evt.momentum_unit() == HepMC3::Units::MEV) ? 1 : 1E3;
+  return ToMeVFactor(evt.momentum_unit());
+}
+
+double ToMeVFactor(HepMC3::Units::MomentumUnit const &unit) {
+  return (unit == HepMC3::Units::MEV) ? 1 : 1E3;
 }
 
 } // namespace Event
@@ -139,7 +448,7 @@ namespace Vertex {
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticlesIn_All(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                   std::vector<int> PDGs) {
+                   std::vector<int> const &PDGs) {
 
   std::vector<HepMC3::ConstGenParticlePtr> parts;
 
@@ -159,25 +468,20 @@ GetParticlesIn_All(HepMC3::ConstGenVertexPtr &evt, int part_status,
 
 HepMC3::ConstGenParticlePtr
 GetParticleIn_HighestMomentum(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                              std::vector<int> PDGs) {
+                              std::vector<int> const &PDGs) {
 
-  auto parts = GetParticlesIn_All(evt, part_status, PDGs);
-  if (!parts.size()) {
-    return nullptr;
-  }
-
-  std::sort(parts.begin(), parts.end(),
-            [](HepMC3::ConstGenParticlePtr &l,
-               HepMC3::ConstGenParticlePtr &r) -> bool {
-              return l->momentum().p3mod2() < r->momentum().p3mod2();
-            });
+  return ArgMax(evt->particles_in(), part_status, PDGs, P3Mod2);
+}
 
-  return parts.back();
+HepMC3::GenParticle const *
+FindParticleIn_HighestMomentum(HepMC3::ConstGenVertexPtr const &vtx,
+                               int part_status, PDGSet const &PDGs) {
+  return ArgMax(vtx->particles_in(), part_status, PDGs, P3Mod2);
 }
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticlesOut_All(HepMC3::ConstGenVertexPtr &vtx, int part_status,
-                    std::vector<int> PDGs) {
+                    std::vector<int> const &PDGs) {
 
   std::vector<HepMC3::ConstGenParticlePtr> parts;
 
@@ -197,20 +501,15 @@ GetParticlesOut_All(HepMC3::ConstGenVertexPtr &vtx, int part_status,
 
 HepMC3::ConstGenParticlePtr
 GetParticleOut_HighestMomentum(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                               std::vector<int> PDGs) {
-
-  auto parts = GetParticlesOut_All(evt, part_status, PDGs);
-  if (!parts.size()) {
-    return nullptr;
-  }
+                               std::vector<int> const &PDGs) {
 
-  std::sort(parts.begin(), parts.end(),
-            [](HepMC3::ConstGenParticlePtr &l,
-               HepMC3::ConstGenParticlePtr &r) -> bool {
-              return l->momentum().p3mod2() < r->momentum().p3mod2();
-            });
+  return ArgMax(evt->particles_out(), part_status, PDGs, P3Mod2);
+}
 
-  return parts.back();
+HepMC3::GenParticle const *
+FindParticleOut_HighestMomentum(HepMC3::ConstGenVertexPtr const &vtx,
+                               int part_status, PDGSet const &PDGs) {
+  return ArgMax(vtx->particles_out(), part_status, PDGs, P3Mod2);
 }
 
 } // namespace Vertex
@@ -2,15 +2,127 @@
 
 #include "NuHepMC/Constants.hxx"
 
+#include "NuHepMC/Exceptions.hxx"
+
 #include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
 #include "HepMC3/GenVertex.h"
 
+#include <array>
+#include <initializer_list>
 #include <vector>
 
 namespace NuHepMC {
 
+NEW_NuHepMC_EXCEPT(TooManyPDGCodes);
+
+// A small set of PDG codes held inline, so that building or querying one never
+// allocates. An empty set matches every PDG code. Sets can be built at compile
+// time, e.g. constexpr PDGSet charged_pions{211, -211};
+class PDGSet {
+public:
+  static constexpr size_t max_size = 16;
+
+  constexpr PDGSet() : codes{}, ncodes(0) {}
+  constexpr PDGSet(std::initializer_list<int> pdgs) : codes{}, ncodes(0) {
+    for (int pdg : pdgs) {
+      insert(pdg);
+    }
+  }
+  explicit PDGSet(std::vector<int> const &pdgs) : codes{}, ncodes(0) {
+    for (int pdg : pdgs) {
+      insert(pdg);
+    }
+  }
+
+  constexpr void insert(int pdg) {
+    if (ncodes == max_size) {
+      throw TooManyPDGCodes() << "PDGSet can hold at most " << max_size
+                              << " PDG codes.";
+    }
+    codes[ncodes++] = pdg;
+  }
+
+  constexpr bool contains(int pdg) const {
+    if (!ncodes) {
+      return true;
+    }
+    for (size_t i = 0; i < ncodes; ++i) {
+      if (codes[i] == pdg) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  constexpr size_t size() const { return ncodes; }
+  constexpr bool empty() const { return !ncodes; }
+
+private:
+  std::array<int, max_size> codes;
+  size_t ncodes;
+};
+
 namespace Event {
 
+// A lookup table for a single event that the query functions below can
+// answer from without rescanning the event. Particle positions are sorted by
+// status, by PDG code, and by both, so building is O(n log n) and each query
+// is a binary search, O(log n + k) for k matches. The primary vertex, beam,
+// and target particles are cached. It refers to the event it was built from,
+// which must outlive it and not be modified. Re-using one Index by calling
+// build for each event re-uses its storage.
+class Index {
+public:
+  // a contiguous run of positions into particles(), in event order
+  struct Range {
+    int const *b;
+    int const *e;
+    int const *begin() const { return b; }
+    int const *end() const { return e; }
+    size_t size() const { return size_t(e - b); }
+  };
+
+  Index() : evt(nullptr) {}
+  explicit Index(HepMC3::GenEvent const &event) : Index() { build(event); }
+
+  void build(HepMC3::GenEvent const &event);
+
+  HepMC3::GenEvent const &event() const { return *evt; }
+  std::vector<HepMC3::ConstGenParticlePtr> const &particles() const {
+    return evt->particles();
+  }
+
+  // part_status = 0 matches any status
+  Range with_status(int part_status) const;
+  Range with_pid(int pid) const;
+  Range with_status_and_pid(int part_status, int pid) const;
+
+  HepMC3::ConstGenVertexPtr first_vertex(int vtx_status) const;
+
+  HepMC3::ConstGenVertexPtr primary_vertex() const { return primary_vtx; }
+  HepMC3::ConstGenParticlePtr beam() const { return beam_part; }
+  HepMC3::ConstGenParticlePtr target() const { return target_part; }
+
+private:
+  HepMC3::GenEvent const *evt;
+
+  std::vector<int> status;
+  std::vector<int> pid;
+
+  std::vector<int> all;
+  std::vector<int> by_status;
+  std::vector<int> by_pid;
+  std::vector<int> by_status_pid;
+
+  // the position of the first vertex with each status, sorted by status
+  std::vector<std::pair<int, int>> first_vtx;
+
+  HepMC3::ConstGenVertexPtr primary_vtx;
+  HepMC3::ConstGenParticlePtr beam_part;
+  HepMC3::ConstGenParticlePtr target_part;
+};
+
 HepMC3::ConstGenVertexPtr GetVertex_First(HepMC3::GenEvent const &evt,
                                     int vtx_status);
 
@@ -23,45 +135,137 @@ int GetTargetPDG(HepMC3::GenEvent const &evt);
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticles_All(HepMC3::GenEvent const &evt, int part_status,
-                 std::vector<int> PDGs = {});
+                 std::vector<int> const &PDGs = {});
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticles_AllRealFinalState(HepMC3::GenEvent const &evt,
-                               std::vector<int> PDGs = {});
+                               std::vector<int> const &PDGs = {});
 
-HepMC3::ConstGenParticlePtr GetParticle_First(HepMC3::GenEvent const &evt,
-                                              int part_status,
-                                              std::vector<int> PDGs = {});
-HepMC3::ConstGenParticlePtr GetParticle_FirstRealFinalState(HepMC3::GenEvent const &evt,
-                                              std::vector<int> PDGs = {});
+HepMC3::ConstGenParticlePtr
+GetParticle_First(HepMC3::GenEvent const &evt, int part_status,
+                  std::vector<int> const &PDGs = {});
+HepMC3::ConstGenParticlePtr
+GetParticle_FirstRealFinalState(HepMC3::GenEvent const &evt,
+                                std::vector<int> const &PDGs = {});
 
 HepMC3::ConstGenParticlePtr
 GetParticle_HighestMomentum(HepMC3::GenEvent const &evt, int part_status,
-                            std::vector<int> PDGs = {});
+                            std::vector<int> const &PDGs = {});
 HepMC3::ConstGenParticlePtr
 GetParticle_HighestMomentumRealFinalState(HepMC3::GenEvent const &evt,
-                            std::vector<int> PDGs = {});
+                            std::vector<int> const &PDGs = {});
+
+// Overloads that answer from a pre-built Index
+HepMC3::ConstGenVertexPtr GetVertex_First(Index const &idx, int vtx_status);
+HepMC3::ConstGenVertexPtr GetPrimaryVertex(Index const &idx);
+HepMC3::ConstGenParticlePtr GetBeamParticle(Index const &idx);
+HepMC3::ConstGenParticlePtr GetTargetParticle(Index const &idx);
+int GetTargetPDG(Index const &idx);
+
+std::vector<HepMC3::ConstGenParticlePtr>
+GetParticles_All(Index const &idx, int part_status,
+                 std::vector<int> const &PDGs = {});
+std::vector<HepMC3::ConstGenParticlePtr>
+GetParticles_AllRealFinalState(Index const &idx,
+                               std::vector<int> const &PDGs = {});
+
+HepMC3::ConstGenParticlePtr
+GetParticle_First(Index const &idx, int part_status,
+                  std::vector<int> const &PDGs = {});
+HepMC3::ConstGenParticlePtr
+GetParticle_FirstRealFinalState(Index const &idx,
+                                std::vector<int> const &PDGs = {});
+
+HepMC3::ConstGenParticlePtr
+GetParticle_HighestMomentum(Index const &idx, int part_status,
+                            std::vector<int> const &PDGs = {});
+HepMC3::ConstGenParticlePtr
+GetParticle_HighestMomentumRealFinalState(Index const &idx,
+                                          std::vector<int> const &PDGs = {});
+
+// Calls f(HepMC3::ConstGenParticlePtr const &part) for each particle in evt
+// with part_status (0 for any) and a PDG code in PDGs, in event order, without
+// allocating or copying any shared pointers.
+template <typename F>
+void VisitParticles(HepMC3::GenEvent const &evt, int part_status,
+                    PDGSet const &PDGs, F &&f) {
+  for (auto const &part : evt.particles()) {
+    if ((!part_status || (part->status() == part_status)) &&
+        PDGs.contains(part->pid())) {
+      f(part);
+    }
+  }
+}
+
+// Clears out and fills it with non-owning pointers to the matching particles,
+// re-using its capacity. Returns the number of particles selected.
+size_t SelectParticles(HepMC3::GenEvent const &evt, int part_status,
+                       PDGSet const &PDGs,
+                       std::vector<HepMC3::GenParticle const *> &out);
+
+// Single-pass searches that return a non-owning pointer to the matching
+// particle, or nullptr if none match. Ties go to the first in event order.
+HepMC3::GenParticle const *FindParticle_First(HepMC3::GenEvent const &evt,
+                                              int part_status,
+                                              PDGSet const &PDGs = {});
+HepMC3::GenParticle const *
+FindParticle_HighestMomentum(HepMC3::GenEvent const &evt, int part_status,
+                             PDGSet const &PDGs = {});
+HepMC3::GenParticle const *
+FindParticle_HighestEnergy(HepMC3::GenEvent const &evt, int part_status,
+                           PDGSet const &PDGs = {});
 
 double ToMeVFactor(HepMC3::GenEvent const &evt);
+double ToMeVFactor(HepMC3::Units::MomentumUnit const &unit);
 } // namespace Event
 
 namespace Vertex {
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticlesIn_All(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                   std::vector<int> PDGs = {});
+                   std::vector<int> const &PDGs = {});
 
 HepMC3::ConstGenParticlePtr
 GetParticleIn_HighestMomentum(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                              std::vector<int> PDGs = {});
+                              std::vector<int> const &PDGs = {});
 
 std::vector<HepMC3::ConstGenParticlePtr>
 GetParticlesOut_All(HepMC3::ConstGenVertexPtr &vtx, int part_status,
-                    std::vector<int> PDGs = {});
+                    std::vector<int> const &PDGs = {});
 
 HepMC3::ConstGenParticlePtr
 GetParticleOut_HighestMomentum(HepMC3::ConstGenVertexPtr &evt, int part_status,
-                               std::vector<int> PDGs = {});
+                               std::vector<int> const &PDGs = {});
+
+// Calls f(HepMC3::ConstGenParticlePtr const &part) for each matching incoming
+// or outgoing particle of vtx, without allocating.
+template <typename F>
+void VisitParticlesIn(HepMC3::ConstGenVertexPtr const &vtx, int part_status,
+                      PDGSet const &PDGs, F &&f) {
+  for (auto const &part : vtx->particles_in()) {
+    if ((!part_status || (part->status() == part_status)) &&
+        PDGs.contains(part->pid())) {
+      f(part);
+    }
+  }
+}
+template <typename F>
+void VisitParticlesOut(HepMC3::ConstGenVertexPtr const &vtx, int part_status,
+                       PDGSet const &PDGs, F &&f) {
+  for (auto const &part : vtx->particles_out()) {
+    if ((!part_status || (part->status() == part_status)) &&
+        PDGs.contains(part->pid())) {
+      f(part);
+    }
+  }
+}
+
+HepMC3::GenParticle const *
+FindParticleIn_HighestMomentum(HepMC3::ConstGenVertexPtr const &vtx,
+                               int part_status, PDGSet const &PDGs = {});
+HepMC3::GenParticle const *
+FindParticleOut_HighestMomentum(HepMC3::ConstGenVertexPtr const &vtx,
+                                int part_status, PDGSet const &PDGs = {});
 
 } // namespace Vertex
 
@@ -8,10 +8,127 @@
 
 #include "fmt/core.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
 namespace NuHepMC {
 
 namespace FATX {
 
+namespace {
+
+char const serialised_magic[] = "NuHepMCFATX";
+uint64_t const serialised_version = 2;
+
+enum class AccumulatorType : uint8_t {
+  kDummy = 0,
+  kGC2 = 1,
+  kEC2 = 2,
+  kEC4 = 3,
+  kMultiWeight = 4,
+};
+
+// fixed-width little-endian so that states can be moved between machines
+void PutU64(std::ostream &os, uint64_t v) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i) {
+    bytes[i] = char((v >> (8 * i)) & 0xff);
+  }
+  os.write(bytes, 8);
+}
+
+uint64_t GetU64(std::istream &is) {
+  unsigned char bytes[8];
+  is.read(reinterpret_cast<char *>(bytes), 8);
+  if (is.gcount() != 8) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised accumulator state ended unexpectedly.";
+  }
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) {
+    v |= uint64_t(bytes[i]) << (8 * i);
+  }
+  return v;
+}
+
+void PutI64(std::ostream &os, int64_t v) { PutU64(os, uint64_t(v)); }
+int64_t GetI64(std::istream &is) { return int64_t(GetU64(is)); }
+
+void PutDouble(std::ostream &os, double v) {
+  uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  PutU64(os, bits);
+}
+
+double GetDouble(std::istream &is) {
+  uint64_t bits = GetU64(is);
+  double v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+void PutUnit(std::ostream &os, CrossSection::Units::Unit const &u) {
+  PutU64(os, uint64_t(u.scale));
+  PutU64(os, uint64_t(u.tgtscale));
+}
+
+CrossSection::Units::Unit GetUnit(std::istream &is) {
+  CrossSection::Units::Unit u;
+  u.scale = CrossSection::Units::Scale(GetU64(is));
+  u.tgtscale = CrossSection::Units::TargetScale(GetU64(is));
+  return u;
+}
+
+void PutString(std::ostream &os, std::string const &str) {
+  PutU64(os, str.size());
+  os.write(str.data(), std::streamsize(str.size()));
+}
+
+std::string GetString(std::istream &is) {
+  std::string str(GetU64(is), '\0');
+  is.read(&str[0], std::streamsize(str.size()));
+  if (size_t(is.gcount()) != str.size()) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised accumulator state ended unexpectedly.";
+  }
+  return str;
+}
+
+void PutDoubles(std::ostream &os, std::vector<double> const &v) {
+  PutU64(os, v.size());
+  for (double d : v) {
+    PutDouble(os, d);
+  }
+}
+
+std::vector<double> GetDoubles(std::istream &is) {
+  std::vector<double> v(GetU64(is));
+  for (double &d : v) {
+    d = GetDouble(is);
+  }
+  return v;
+}
+
+// one step of a compensated sum, written out rather than using KBAccumulator
+// so that loops over contiguous arrays of sums can be vectorised
+inline void KahanAdd(double &sum, double &corr, double el) {
+  double y = el - corr;
+  double t = sum + y;
+  corr = (t - sum) - y;
+  sum = t;
+}
+
+void PutHeader(std::ostream &os, AccumulatorType type) {
+  os.write(serialised_magic, sizeof(serialised_magic));
+  PutU64(os, serialised_version);
+  os.put(char(type));
+}
+
+} // namespace
+
 template <typename T = double> class KBAccumulator {
   T sum;
   T corr;
@@ -27,25 +144,58 @@ public:
     sum = t;
   }
   T operator()() const { return sum; }
+
+  // folds another compensated sum into this one, including its running
+  // correction, so that merged partial sums are as accurate as if every
+  // element had been added here
+  void operator()(KBAccumulator const &other) {
+    (*this)(other.sum);
+    (*this)(-other.corr);
+  }
+
+  void write(std::ostream &os) const {
+    PutDouble(os, sum);
+    PutDouble(os, corr);
+  }
+  void read(std::istream &is) {
+    sum = GetDouble(is);
+    corr = GetDouble(is);
+  }
 };
 
+template <typename T>
+T const &CastForMerge(Accumulator const &other, char const *into) {
+  auto const *o = dynamic_cast<T const *>(&other);
+  if (!o) {
+    throw IncompatibleAccumulators()
+        << "Attempted to merge a different type of accumulator into a "
+        << into;
+  }
+  return *o;
+}
+
 struct BaseAccumulator : public Accumulator {
 
   KBAccumulator<double> sumw;
   std::map<int, KBAccumulator<double>> targets_sumw;
+  KBAccumulator<double> sumw2;
+  std::map<int, KBAccumulator<double>> targets_sumw2;
 
   CrossSection::Units::Unit input_unit;
   size_t nevt;
   int cvweight_index;
 
   BaseAccumulator(int cvwi = -1)
-      : sumw(), input_unit{CrossSection::Units::automatic}, nevt{0},
+      : sumw(), sumw2(), input_unit{CrossSection::Units::automatic}, nevt{0},
         cvweight_index{cvwi} {}
 
   double process(HepMC3::GenEvent const &ev) {
     double w = (cvweight_index == -1) ? 1 : ev.weights()[cvweight_index];
+    auto tgt_pdg = Event::GetTargetPDG(ev);
     sumw(w);
-    targets_sumw[Event::GetTargetPDG(ev)](w);
+    targets_sumw[tgt_pdg](w);
+    sumw2(w * w);
+    targets_sumw2[tgt_pdg](w * w);
     nevt++;
 
     if (input_unit == CrossSection::Units::automatic) {
@@ -63,6 +213,57 @@ struct BaseAccumulator : public Accumulator {
     return w;
   }
 
+  void merge_base(BaseAccumulator const &other) {
+    if (input_unit == CrossSection::Units::automatic) {
+      input_unit = other.input_unit;
+    } else if ((other.input_unit != CrossSection::Units::automatic) &&
+               (other.input_unit != input_unit)) {
+      throw IncompatibleAccumulators()
+          << "Cannot merge accumulators that saw events with different cross "
+             "section units: "
+          << input_unit << " and " << other.input_unit;
+    }
+
+    sumw(other.sumw);
+    for (auto const &[tgt_pid, tgt_sumw] : other.targets_sumw) {
+      targets_sumw[tgt_pid](tgt_sumw);
+    }
+    sumw2(other.sumw2);
+    for (auto const &[tgt_pid, tgt_sumw2] : other.targets_sumw2) {
+      targets_sumw2[tgt_pid](tgt_sumw2);
+    }
+    nevt += other.nevt;
+  }
+
+  void write_base(std::ostream &os) const {
+    PutI64(os, cvweight_index);
+    PutUnit(os, input_unit);
+    PutU64(os, nevt);
+    sumw.write(os);
+    PutU64(os, targets_sumw.size());
+    for (auto const &[tgt_pid, tgt_sumw] : targets_sumw) {
+      PutI64(os, tgt_pid);
+      tgt_sumw.write(os);
+      targets_sumw2.at(tgt_pid).write(os);
+    }
+    sumw2.write(os);
+  }
+
+  void read_base(std::istream &is) {
+    cvweight_index = int(GetI64(is));
+    input_unit = GetUnit(is);
+    nevt = GetU64(is);
+    sumw.read(is);
+    targets_sumw.clear();
+    targets_sumw2.clear();
+    for (uint64_t i = 0, ntgts = GetU64(is); i < ntgts; ++i) {
+      int tgt_pid = int(GetI64(is));
+      targets_sumw[tgt_pid].read(is);
+      targets_sumw2[tgt_pid].read(is);
+    }
+    sumw2.read(is);
+  }
+
   double units_scale_factor(CrossSection::Units::Unit const &to) const {
     double sf = 1;
 
@@ -86,6 +287,8 @@ struct BaseAccumulator : public Accumulator {
     std::stringstream ss;
     ss << "nevt: " << nevt << std::endl;
     ss << "sumw: " << sumw() << std::endl;
+    ss << "sumw2: " << sumw2() << std::endl;
+    ss << "effective_sample_size: " << effective_sample_size() << std::endl;
     if (targets_sumw.size() > 1) {
       ss << "targets_sumw: " << std::endl;
       ss << "  Target PDG  sumw" << std::endl;
@@ -98,6 +301,7 @@ struct BaseAccumulator : public Accumulator {
     ss << "fatx: " << fatx(CrossSection::Units::pb_PerAtom) << " pb/Atom, "
        << fatx(CrossSection::Units::cm2ten38_PerNucleon)
        << " cm^2 * 10^-38/Nucleon" << std::endl;
+    ss << "fatx_relative_error: " << fatx_relative_error() << std::endl;
 
     return ss.str();
   }
@@ -148,6 +352,30 @@ struct BaseAccumulator : public Accumulator {
 
   double sumweights() const { return sumw(); }
   size_t events() const { return nevt; }
+
+  double sumweights2() const { return sumw2(); }
+  std::map<int, double> targets_sumweights() const {
+    std::map<int, double> tsumw;
+    for (auto const &[tgt_pid, tgt_sumw] : targets_sumw) {
+      tsumw[tgt_pid] = tgt_sumw();
+    }
+    return tsumw;
+  }
+  double effective_sample_size() const {
+    return sumw2() ? ((sumw() * sumw()) / sumw2()) : 0;
+  }
+  double effective_sample_size(int target_pdg) const {
+    auto it = targets_sumw.find(target_pdg);
+    if (it == targets_sumw.end()) {
+      return 0;
+    }
+    double tgt_sumw2 = targets_sumw2.at(target_pdg)();
+    return tgt_sumw2 ? ((it->second() * it->second()) / tgt_sumw2) : 0;
+  }
+
+  // the FATX is read from the input, subclasses that estimate it override
+  double fatx_relative_error() const { return 0; }
+  double fatx_relative_error(int) const { return 0; }
 };
 
 struct DummyAccumulator : public Accumulator {
@@ -163,7 +391,46 @@ struct DummyAccumulator : public Accumulator {
 
   double sumweights() const { return nevt; }
   size_t events() const { return nevt; }
+  double sumweights2() const { return nevt; }
+  std::map<int, double> targets_sumweights() const {
+    return std::map<int, double>(targets_nevt.begin(), targets_nevt.end());
+  }
+  double effective_sample_size() const { return nevt; }
+  double effective_sample_size(int target_pdg) const {
+    auto it = targets_nevt.find(target_pdg);
+    return (it == targets_nevt.end()) ? 0 : it->second;
+  }
+  double fatx_relative_error() const { return 0; }
+  double fatx_relative_error(int) const { return 0; }
   std::string to_string() const { return "DummyAccumulator"; }
+
+  std::shared_ptr<Accumulator> clone() const {
+    return std::shared_ptr<Accumulator>(new DummyAccumulator());
+  }
+  void merge(Accumulator const &other) {
+    auto const &o = CastForMerge<DummyAccumulator>(other, "DummyAccumulator");
+    nevt += o.nevt;
+    for (auto const &[tgt_pid, tgt_nevt] : o.targets_nevt) {
+      targets_nevt[tgt_pid] += tgt_nevt;
+    }
+  }
+  void serialise(std::ostream &os) const {
+    PutHeader(os, AccumulatorType::kDummy);
+    PutU64(os, nevt);
+    PutU64(os, targets_nevt.size());
+    for (auto const &[tgt_pid, tgt_nevt] : targets_nevt) {
+      PutI64(os, tgt_pid);
+      PutU64(os, tgt_nevt);
+    }
+  }
+  void read(std::istream &is) {
+    nevt = GetU64(is);
+    targets_nevt.clear();
+    for (uint64_t i = 0, ntgts = GetU64(is); i < ntgts; ++i) {
+      int tgt_pid = int(GetI64(is));
+      targets_nevt[tgt_pid] = GetU64(is);
+    }
+  }
   int TargetTotalNucleons() const {
     int TotNucleons = 0;
     for (auto const &[tgt_pid, tgt_nevt] : targets_nevt) {
@@ -298,6 +565,33 @@ struct GC2Accumulator : public BaseAccumulator {
     ss << "GC2FATX: " << GC2FATX << std::endl;
     return ss.str();
   }
+
+  std::shared_ptr<Accumulator> clone() const {
+    return std::shared_ptr<Accumulator>(new GC2Accumulator(cvweight_index));
+  }
+  void merge(Accumulator const &other) {
+    auto const &o = CastForMerge<GC2Accumulator>(other, "GC2Accumulator");
+    if (GC2FATX == 0xdeadbeef) {
+      GC2FATX = o.GC2FATX;
+    } else if ((o.GC2FATX != 0xdeadbeef) && (o.GC2FATX != GC2FATX)) {
+      // G.C.2 is a single run-level value, so differing ones mean the events
+      // come from different samples
+      throw IncompatibleAccumulators()
+          << "Cannot merge GC2Accumulators for runs with different G.C.2 flux "
+             "averaged total cross sections: "
+          << GC2FATX << " and " << o.GC2FATX;
+    }
+    merge_base(o);
+  }
+  void serialise(std::ostream &os) const {
+    PutHeader(os, AccumulatorType::kGC2);
+    write_base(os);
+    PutDouble(os, GC2FATX);
+  }
+  void read(std::istream &is) {
+    read_base(is);
+    GC2FATX = GetDouble(is);
+  }
 };
 
 // This constructs the FATX from the total cross section for each event
@@ -307,8 +601,43 @@ struct EC2Accumulator : public BaseAccumulator {
   KBAccumulator<double> ReciprocalTotXS;
   std::map<int, KBAccumulator<double>> targets_ReciprocalTotXS;
 
+  // the cross terms needed for the variance of the ratio estimator
+  //   fatx = sum(w) / sum(r), r = w / xs
+  KBAccumulator<double> SumWR;
+  KBAccumulator<double> SumR2;
+  std::map<int, KBAccumulator<double>> targets_SumWR;
+  std::map<int, KBAccumulator<double>> targets_SumR2;
+
   EC2Accumulator(int cvwi = -1) : BaseAccumulator(cvwi), ReciprocalTotXS() {}
 
+  // The linearised variance of a ratio of sums,
+  //   var(fatx) = sum((w - fatx * r)^2) / sum(r)^2,
+  // expanded in terms of the accumulated sums.
+  static double RatioRelativeError(double sw, double sw2, double sr,
+                                   double swr, double sr2) {
+    if (!sr || !sw) {
+      return 0;
+    }
+    double R = sw / sr;
+    double var = (sw2 - (2 * R * swr) + (R * R * sr2)) / (sr * sr);
+    return (var > 0) ? (std::sqrt(var) / R) : 0;
+  }
+
+  double fatx_relative_error() const {
+    return RatioRelativeError(sumw(), sumw2(), ReciprocalTotXS(), SumWR(),
+                              SumR2());
+  }
+  double fatx_relative_error(int target_pdg) const {
+    auto it = targets_ReciprocalTotXS.find(target_pdg);
+    if (it == targets_ReciprocalTotXS.end()) {
+      return 0;
+    }
+    return RatioRelativeError(targets_sumw.at(target_pdg)(),
+                              targets_sumw2.at(target_pdg)(), it->second(),
+                              targets_SumWR.at(target_pdg)(),
+                              targets_SumR2.at(target_pdg)());
+  }
+
   double process(HepMC3::GenEvent const &ev) {
     double w = BaseAccumulator::process(ev);
 
@@ -324,6 +653,10 @@ struct EC2Accumulator : public BaseAccumulator {
 
     ReciprocalTotXS(totxs_recip);
     targets_ReciprocalTotXS[tgt_pdg](totxs_recip);
+    SumWR(w * totxs_recip);
+    targets_SumWR[tgt_pdg](w * totxs_recip);
+    SumR2(totxs_recip * totxs_recip);
+    targets_SumR2[tgt_pdg](totxs_recip * totxs_recip);
 
     return w;
   }
@@ -411,6 +744,51 @@ struct EC2Accumulator : public BaseAccumulator {
     }
     return ss.str();
   }
+
+  std::shared_ptr<Accumulator> clone() const {
+    return std::shared_ptr<Accumulator>(new EC2Accumulator(cvweight_index));
+  }
+  void merge(Accumulator const &other) {
+    auto const &o = CastForMerge<EC2Accumulator>(other, "EC2Accumulator");
+    merge_base(o);
+    ReciprocalTotXS(o.ReciprocalTotXS);
+    SumWR(o.SumWR);
+    SumR2(o.SumR2);
+    for (auto const &[tgt_pid, tgt_rtxs] : o.targets_ReciprocalTotXS) {
+      targets_ReciprocalTotXS[tgt_pid](tgt_rtxs);
+      targets_SumWR[tgt_pid](o.targets_SumWR.at(tgt_pid));
+      targets_SumR2[tgt_pid](o.targets_SumR2.at(tgt_pid));
+    }
+  }
+  void serialise(std::ostream &os) const {
+    PutHeader(os, AccumulatorType::kEC2);
+    write_base(os);
+    ReciprocalTotXS.write(os);
+    SumWR.write(os);
+    SumR2.write(os);
+    PutU64(os, targets_ReciprocalTotXS.size());
+    for (auto const &[tgt_pid, tgt_rtxs] : targets_ReciprocalTotXS) {
+      PutI64(os, tgt_pid);
+      tgt_rtxs.write(os);
+      targets_SumWR.at(tgt_pid).write(os);
+      targets_SumR2.at(tgt_pid).write(os);
+    }
+  }
+  void read(std::istream &is) {
+    read_base(is);
+    ReciprocalTotXS.read(is);
+    SumWR.read(is);
+    SumR2.read(is);
+    targets_ReciprocalTotXS.clear();
+    targets_SumWR.clear();
+    targets_SumR2.clear();
+    for (uint64_t i = 0, ntgts = GetU64(is); i < ntgts; ++i) {
+      int tgt_pid = int(GetI64(is));
+      targets_ReciprocalTotXS[tgt_pid].read(is);
+      targets_SumWR[tgt_pid].read(is);
+      targets_SumR2[tgt_pid].read(is);
+    }
+  }
 };
 
 // This reads the FATX from the last event
@@ -425,6 +803,12 @@ struct EC4Accumulator : public BaseAccumulator {
   double process(HepMC3::GenEvent const &ev) {
     double w = BaseAccumulator::process(ev);
 
+    if (!ev.cross_section()) {
+      throw MissingEventCrossSection()
+          << "EC4Accumulator was passed event " << ev.event_number()
+          << " with no GenCrossSection, E.C.4 requires every event to carry "
+             "the running FATX estimate.";
+    }
     EC4BestEstimate = ev.cross_section()->xsec();
     return w;
   }
@@ -502,6 +886,27 @@ struct EC4Accumulator : public BaseAccumulator {
     ss << "EC4BestEstimate: " << EC4BestEstimate << std::endl;
     return ss.str();
   }
+
+  std::shared_ptr<Accumulator> clone() const {
+    return std::shared_ptr<Accumulator>(new EC4Accumulator(cvweight_index));
+  }
+  void merge(Accumulator const &other) {
+    auto const &o = CastForMerge<EC4Accumulator>(other, "EC4Accumulator");
+    merge_base(o);
+    // the best estimate is the one from the last event seen
+    if (o.nevt) {
+      EC4BestEstimate = o.EC4BestEstimate;
+    }
+  }
+  void serialise(std::ostream &os) const {
+    PutHeader(os, AccumulatorType::kEC4);
+    write_base(os);
+    PutDouble(os, EC4BestEstimate);
+  }
+  void read(std::istream &is) {
+    read_base(is);
+    EC4BestEstimate = GetDouble(is);
+  }
 };
 
 NEW_NuHepMC_EXCEPT(NoMethodToCalculateFATX);
@@ -531,6 +936,26 @@ MakeAccumulator(std::shared_ptr<HepMC3::GenRunInfo> gri) {
       << CheckedAttributeValue<std::string>(gri, "NuHepMC.Conventions", "");
 }
 
+std::shared_ptr<Accumulator> MakeAccumulator(RunInfoView const &view) {
+  if (view.signals(ConventionBit("G.C.2"))) {
+    return std::shared_ptr<Accumulator>(
+        new GC2Accumulator(view.cv_weight_index));
+  } else if (view.signals(ConventionBit("E.C.4"))) {
+    return std::shared_ptr<Accumulator>(
+        new EC4Accumulator(view.cv_weight_index));
+  } else if (view.signals(ConventionBit("E.C.2"))) {
+    return std::shared_ptr<Accumulator>(
+        new EC2Accumulator(view.cv_weight_index));
+  }
+
+  throw NoMethodToCalculateFATX()
+      << "GenRunInfo did not signal any of the possible FATX accumulator "
+         "conventions. Can only use G.C.2, E.C.2, or E.C.4.\nConventions "
+         "signalled: "
+      << CheckedAttributeValue<std::string>(view.run_info,
+                                            "NuHepMC.Conventions", "");
+}
+
 std::shared_ptr<Accumulator> MakeAccumulator(std::string const &Convention) {
   if (Convention == "G.C.2") {
     return std::shared_ptr<Accumulator>(new GC2Accumulator());
@@ -547,5 +972,354 @@ std::shared_ptr<Accumulator> MakeAccumulator(std::string const &Convention) {
                                      "E.C.2 to build a FATX accumulator.";
 }
 
+MultiWeightAccumulator::MultiWeightAccumulator()
+    : cv(new DummyAccumulator()), method(Method::kSumWeights), cv_index(-1),
+      cv_recip(0), cv_recip_corr(0) {}
+
+MultiWeightAccumulator::MultiWeightAccumulator(
+    std::shared_ptr<Accumulator> cv_acc, Method meth,
+    std::vector<std::string> weight_names, int cv_weight_index)
+    : cv(std::move(cv_acc)), method(meth), names(std::move(weight_names)),
+      cv_index(cv_weight_index), sumw(names.size(), 0),
+      sumw_corr(names.size(), 0), cv_recip(0), cv_recip_corr(0) {
+  if (method == Method::kReciprocalXSec) {
+    recip.assign(names.size(), 0);
+    recip_corr.assign(names.size(), 0);
+  }
+}
+
+double MultiWeightAccumulator::process(HepMC3::GenEvent const &ev) {
+  if ((method == Method::kEventXSec) && !ev.cross_section()) {
+    throw MissingEventCrossSection()
+        << "MultiWeightAccumulator was passed event " << ev.event_number()
+        << " with no GenCrossSection, E.C.4 requires every event to carry the "
+           "per-weight FATX estimates.";
+  }
+  double w = cv->process(ev);
+
+  auto const &weights = ev.weights();
+  size_t const n = names.size();
+  if (weights.size() != n) {
+    throw WeightVectorSizeMismatch()
+        << "MultiWeightAccumulator configured with " << n
+        << " weight names was passed an event with " << weights.size()
+        << " weights.";
+  }
+
+  double const *wv = weights.data();
+  double *s = sumw.data();
+  double *c = sumw_corr.data();
+  for (size_t i = 0; i < n; ++i) {
+    KahanAdd(s[i], c[i], wv[i]);
+  }
+
+  switch (method) {
+  case Method::kReciprocalXSec: {
+    double xs = EC2::ReadTotalCrossSection(ev);
+    if (!xs) { // skip events with 0 cross section, as EC2Accumulator
+      break;
+    }
+    double inv_xs = 1.0 / xs;
+    double *r = recip.data();
+    double *rc = recip_corr.data();
+    for (size_t i = 0; i < n; ++i) {
+      KahanAdd(r[i], rc[i], wv[i] * inv_xs);
+    }
+    KahanAdd(cv_recip, cv_recip_corr, inv_xs);
+    break;
+  }
+  case Method::kEventXSec: {
+    auto const &xsecs = ev.cross_section()->xsecs();
+    if (xsecs.size() == n) {
+      last_xsecs = xsecs;
+    } else {
+      last_xsecs.clear();
+    }
+    break;
+  }
+  default: {
+    break;
+  }
+  }
+
+  return w;
+}
+
+size_t MultiWeightAccumulator::index(std::string const &weight_name) const {
+  auto it = std::find(names.begin(), names.end(), weight_name);
+  if (it == names.end()) {
+    throw UnknownWeightName()
+        << "MultiWeightAccumulator has no weight named: " << weight_name;
+  }
+  return size_t(it - names.begin());
+}
+
+double MultiWeightAccumulator::sumweights(size_t universe) const {
+  return sumw.at(universe);
+}
+
+std::vector<double> MultiWeightAccumulator::all_sumweights() const {
+  return sumw;
+}
+
+double MultiWeightAccumulator::ratio_to_cv(size_t universe) const {
+  bool has_cv = (cv_index >= 0);
+  double ref_sumw = has_cv ? sumw[size_t(cv_index)] : cv->sumweights();
+
+  switch (method) {
+  case Method::kReciprocalXSec: {
+    double ref_recip = has_cv ? recip[size_t(cv_index)] : cv_recip;
+    return (sumw[universe] / recip[universe]) / (ref_sumw / ref_recip);
+  }
+  case Method::kEventXSec: {
+    if (!last_xsecs.empty()) {
+      return last_xsecs[universe] / last_xsecs[has_cv ? size_t(cv_index) : 0];
+    }
+    return sumw[universe] / ref_sumw;
+  }
+  default: {
+    return sumw[universe] / ref_sumw;
+  }
+  }
+}
+
+double
+MultiWeightAccumulator::fatx(size_t universe,
+                             CrossSection::Units::Unit const &units) const {
+  if (universe >= names.size()) {
+    throw UnknownWeightName() << "MultiWeightAccumulator has no universe "
+                              << universe << ", it has " << names.size();
+  }
+  return cv->fatx(units) * ratio_to_cv(universe);
+}
+
+std::vector<double>
+MultiWeightAccumulator::all_fatx(CrossSection::Units::Unit const &units) const {
+  double cv_fatx = cv->fatx(units);
+  std::vector<double> fatxs(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    fatxs[i] = cv_fatx * ratio_to_cv(i);
+  }
+  return fatxs;
+}
+
+std::string MultiWeightAccumulator::to_string() const {
+  std::stringstream ss;
+  ss << cv->to_string();
+  ss << "universes: " << names.size() << std::endl;
+  ss << "  weight  sumw  fatx/pb/Atom" << std::endl;
+  ss << "  --------------------------" << std::endl;
+  for (size_t i = 0; i < names.size(); ++i) {
+    ss << "  " << names[i] << "  " << sumw[i] << "  "
+       << fatx(i, CrossSection::Units::pb_PerAtom) << std::endl;
+  }
+  return ss.str();
+}
+
+std::shared_ptr<Accumulator> MultiWeightAccumulator::clone() const {
+  return std::shared_ptr<Accumulator>(
+      new MultiWeightAccumulator(cv->clone(), method, names, cv_index));
+}
+
+void MultiWeightAccumulator::merge(Accumulator const &other) {
+  auto const &o =
+      CastForMerge<MultiWeightAccumulator>(other, "MultiWeightAccumulator");
+  if ((o.method != method) || (o.names != names) ||
+      (o.cv_index != cv_index)) {
+    throw IncompatibleAccumulators()
+        << "Cannot merge MultiWeightAccumulators configured with different "
+           "weights or FATX methods.";
+  }
+
+  cv->merge(*o.cv);
+  for (size_t i = 0; i < sumw.size(); ++i) {
+    KahanAdd(sumw[i], sumw_corr[i], o.sumw[i]);
+    KahanAdd(sumw[i], sumw_corr[i], -o.sumw_corr[i]);
+  }
+  for (size_t i = 0; i < recip.size(); ++i) {
+    KahanAdd(recip[i], recip_corr[i], o.recip[i]);
+    KahanAdd(recip[i], recip_corr[i], -o.recip_corr[i]);
+  }
+  KahanAdd(cv_recip, cv_recip_corr, o.cv_recip);
+  KahanAdd(cv_recip, cv_recip_corr, -o.cv_recip_corr);
+  // as for EC4Accumulator, the best estimates are from the last event seen
+  if (o.events()) {
+    last_xsecs = o.last_xsecs;
+  }
+}
+
+void MultiWeightAccumulator::serialise(std::ostream &os) const {
+  PutHeader(os, AccumulatorType::kMultiWeight);
+  PutU64(os, uint64_t(method));
+  PutI64(os, cv_index);
+  PutU64(os, names.size());
+  for (auto const &name : names) {
+    PutString(os, name);
+  }
+  PutDoubles(os, sumw);
+  PutDoubles(os, sumw_corr);
+  PutDoubles(os, recip);
+  PutDoubles(os, recip_corr);
+  PutDouble(os, cv_recip);
+  PutDouble(os, cv_recip_corr);
+  PutDoubles(os, last_xsecs);
+  cv->serialise(os);
+}
+
+void MultiWeightAccumulator::read(std::istream &is) {
+  auto meth = GetU64(is);
+  if (meth > uint64_t(Method::kEventXSec)) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised MultiWeightAccumulator has unknown method: " << meth;
+  }
+  method = Method(meth);
+  cv_index = int(GetI64(is));
+  names.resize(GetU64(is));
+  for (auto &name : names) {
+    name = GetString(is);
+  }
+  sumw = GetDoubles(is);
+  sumw_corr = GetDoubles(is);
+  recip = GetDoubles(is);
+  recip_corr = GetDoubles(is);
+  cv_recip = GetDouble(is);
+  cv_recip_corr = GetDouble(is);
+  last_xsecs = GetDoubles(is);
+
+  // every per-universe array is indexed by universe, the reciprocal sums are
+  // only kept by kReciprocalXSec, and the last cross sections are kept only
+  // when the last event had one per weight
+  size_t const n = names.size();
+  size_t const nrecip = (method == Method::kReciprocalXSec) ? n : 0;
+  if ((sumw.size() != n) || (sumw_corr.size() != n) ||
+      (recip.size() != nrecip) || (recip_corr.size() != nrecip) ||
+      (last_xsecs.size() && (last_xsecs.size() != n))) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised MultiWeightAccumulator has " << n
+        << " weight names but " << sumw.size() << " and " << sumw_corr.size()
+        << " sums of weights, " << recip.size() << " and " << recip_corr.size()
+        << " sums of reciprocal cross sections, and " << last_xsecs.size()
+        << " event cross sections.";
+  }
+  if ((cv_index < -1) || (cv_index >= int(n))) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised MultiWeightAccumulator has CV weight index " << cv_index
+        << " but only " << n << " weight names.";
+  }
+  cv = Deserialise(is);
+}
+
+std::shared_ptr<MultiWeightAccumulator>
+MakeMultiWeightAccumulator(std::shared_ptr<HepMC3::GenRunInfo> gri) {
+  auto cv = MakeAccumulator(gri);
+
+  // same order of precedence as MakeAccumulator
+  auto method = MultiWeightAccumulator::Method::kReciprocalXSec;
+  if (GR4::SignalsConvention(gri, "G.C.2")) {
+    method = MultiWeightAccumulator::Method::kSumWeights;
+  } else if (GR4::SignalsConvention(gri, "E.C.4")) {
+    method = MultiWeightAccumulator::Method::kEventXSec;
+  }
+
+  return std::make_shared<MultiWeightAccumulator>(
+      cv, method, gri->weight_names(), gri->weight_index("CV"));
+}
+
+template <typename T>
+std::shared_ptr<Accumulator> ReadAccumulator(std::istream &is) {
+  auto acc = std::make_shared<T>();
+  acc->read(is);
+  return acc;
+}
+
+std::shared_ptr<Accumulator> Deserialise(std::istream &is) {
+  char magic[sizeof(serialised_magic)];
+  is.read(magic, sizeof(magic));
+  if ((is.gcount() != sizeof(magic)) ||
+      std::memcmp(magic, serialised_magic, sizeof(magic))) {
+    throw InvalidSerialisedAccumulator()
+        << "Stream does not contain a serialised FATX accumulator.";
+  }
+
+  auto version = GetU64(is);
+  if (version != serialised_version) {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised FATX accumulator has format version " << version
+        << ", but this version of NuHepMC_CPPUtils reads version "
+        << serialised_version;
+  }
+
+  int type = is.get();
+  switch (AccumulatorType(type)) {
+  case AccumulatorType::kDummy: {
+    return ReadAccumulator<DummyAccumulator>(is);
+  }
+  case AccumulatorType::kGC2: {
+    return ReadAccumulator<GC2Accumulator>(is);
+  }
+  case AccumulatorType::kEC2: {
+    return ReadAccumulator<EC2Accumulator>(is);
+  }
+  case AccumulatorType::kEC4: {
+    return ReadAccumulator<EC4Accumulator>(is);
+  }
+  case AccumulatorType::kMultiWeight: {
+    return ReadAccumulator<MultiWeightAccumulator>(is);
+  }
+  default: {
+    throw InvalidSerialisedAccumulator()
+        << "Serialised FATX accumulator has unknown type: " << type;
+  }
+  }
+}
+
+std::string SummaryFilename(std::string const &filename) {
+  return filename + ".fatx";
+}
+
+void WriteSummary(Accumulator const &acc, std::string const &filename) {
+  std::error_code ec;
+  auto file_size = std::filesystem::file_size(filename, ec);
+  if (ec) {
+    throw InvalidSerialisedAccumulator()
+        << "Cannot write a FATX summary for " << filename
+        << " as its size could not be read: " << ec.message();
+  }
+
+  auto summary_filename = SummaryFilename(filename);
+  std::ofstream ofs(summary_filename, std::ios::binary);
+  PutU64(ofs, file_size);
+  acc.serialise(ofs);
+  if (!ofs) {
+    throw InvalidSerialisedAccumulator()
+        << "Failed to write FATX summary: " << summary_filename;
+  }
+}
+
+std::shared_ptr<Accumulator> ReadSummary(std::string const &filename) {
+  auto summary_filename = SummaryFilename(filename);
+
+  std::error_code ec;
+  if (!std::filesystem::exists(summary_filename, ec)) {
+    return nullptr;
+  }
+  auto file_size = std::filesystem::file_size(filename, ec);
+  if (ec || (std::filesystem::last_write_time(summary_filename, ec) <
+             std::filesystem::last_write_time(filename, ec))) {
+    return nullptr;
+  }
+
+  std::ifstream ifs(summary_filename, std::ios::binary);
+  try {
+    if (GetU64(ifs) != file_size) {
+      return nullptr;
+    }
+    return Deserialise(ifs);
+  } catch (InvalidSerialisedAccumulator const &) {
+    // a stale or truncated summary is as good as none
+    return nullptr;
+  }
+}
+
 } // namespace FATX
 } // namespace NuHepMC
@@ -1,7 +1,16 @@
 #pragma once
 
+#include "NuHepMC/RunInfoView.hxx"
 #include "NuHepMC/UnitsUtils.hxx"
 
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
 namespace HepMC3 {
 class GenEvent;
 class GenRunInfo;
@@ -11,6 +20,12 @@ namespace NuHepMC {
 
 namespace FATX {
 
+NEW_NuHepMC_EXCEPT(IncompatibleAccumulators);
+NEW_NuHepMC_EXCEPT(InvalidSerialisedAccumulator);
+NEW_NuHepMC_EXCEPT(UnknownWeightName);
+NEW_NuHepMC_EXCEPT(WeightVectorSizeMismatch);
+NEW_NuHepMC_EXCEPT(MissingEventCrossSection);
+
 // ABC for FATX accumulators that can give their best estimate of the FATX after
 // being passed N events
 // Some subclasses will know the best estimate after one event and others will
@@ -25,8 +40,37 @@ struct Accumulator {
   virtual double sumweights() const = 0;
   virtual size_t events() const = 0;
 
+  // the sum of squared weights and the effective sample size,
+  // (sum w)^2 / sum w^2, of all processed events or those on one target
+  virtual double sumweights2() const = 0;
+  // the sum of weights of processed events by target PDG code
+  virtual std::map<int, double> targets_sumweights() const = 0;
+  virtual double effective_sample_size() const = 0;
+  virtual double effective_sample_size(int target_pdg) const = 0;
+  // the estimated statistical uncertainty of the fatx relative to its value,
+  // for all targets or the contribution from one. Is 0 for conventions where
+  // the FATX is read from the input rather than estimated from the events
+  virtual double fatx_relative_error() const = 0;
+  virtual double fatx_relative_error(int target_pdg) const = 0;
+
+  // true once enough events have been processed that the relative error of
+  // the fatx is no larger than rel_tolerance
+  bool is_converged(double rel_tolerance) const {
+    return (events() > 1) && (fatx_relative_error() <= rel_tolerance);
+  }
+
   virtual std::string to_string() const = 0;
 
+  // returns a new, empty accumulator configured in the same way as this one
+  virtual std::shared_ptr<Accumulator> clone() const = 0;
+  // combines the events seen by other, which must be the same type of
+  // accumulator, into this one, as if they were processed after the events
+  // already seen by this accumulator
+  virtual void merge(Accumulator const &other) = 0;
+  // writes the accumulated state in a compact, portable binary format that
+  // can be read back with FATX::Deserialise
+  virtual void serialise(std::ostream &os) const = 0;
+
   virtual int TargetTotalNucleons() const = 0;
   virtual int TargetTotalProtons() const = 0;
   virtual int TargetTotalNeutrons() const = 0;
@@ -40,11 +84,138 @@ struct Accumulator {
 
 std::shared_ptr<Accumulator>
 MakeAccumulator(std::shared_ptr<HepMC3::GenRunInfo> gri);
+std::shared_ptr<Accumulator> MakeAccumulator(RunInfoView const &view);
 
 // Can pass Convention = "Dummy" to instantiate an accumulator that
 // just counts events.
 std::shared_ptr<Accumulator> MakeAccumulator(std::string const &Convention);
 
+// Accumulates every G.R.7 weight of each event, one universe per weight, as
+// well as running the CV accumulator for the file's FATX convention. The sums
+// of weights are kept contiguously by universe and updated with compensated
+// summation in one loop over the event's weight vector that the compiler can
+// vectorise.
+//
+// The FATX of a universe is the CV FATX scaled by the ratio of the universe's
+// and the CV's estimate with the convention's method: the sum of weights for
+// G.C.2, the sum of weights over the sum of weight / E.C.2 cross section for
+// E.C.2, and the per-weight event cross sections for E.C.4 when the events
+// carry one per weight, falling back to the sum of weights otherwise.
+class MultiWeightAccumulator : public Accumulator {
+public:
+  enum class Method : uint8_t {
+    kSumWeights = 0,
+    kReciprocalXSec = 1,
+    kEventXSec = 2,
+  };
+
+  // an empty accumulator to read a serialised state into
+  MultiWeightAccumulator();
+  MultiWeightAccumulator(std::shared_ptr<Accumulator> cv, Method method,
+                         std::vector<std::string> weight_names,
+                         int cv_weight_index);
+
+  double process(HepMC3::GenEvent const &ev);
+
+  size_t size() const { return names.size(); }
+  std::vector<std::string> const &weight_names() const { return names; }
+  // throws UnknownWeightName
+  size_t index(std::string const &weight_name) const;
+
+  double sumweights() const { return cv->sumweights(); }
+  double sumweights(size_t universe) const;
+  double sumweights(std::string const &weight_name) const {
+    return sumweights(index(weight_name));
+  }
+  std::vector<double> all_sumweights() const;
+
+  double fatx(CrossSection::Units::Unit const &units =
+                  CrossSection::Units::pb_PerAtom) const {
+    return cv->fatx(units);
+  }
+  double fatx(size_t universe, CrossSection::Units::Unit const &units =
+                                   CrossSection::Units::pb_PerAtom) const;
+  double fatx(std::string const &weight_name,
+              CrossSection::Units::Unit const &units =
+                  CrossSection::Units::pb_PerAtom) const {
+    return fatx(index(weight_name), units);
+  }
+  std::vector<double> all_fatx(CrossSection::Units::Unit const &units =
+                                   CrossSection::Units::pb_PerAtom) const;
+
+  size_t events() const { return cv->events(); }
+
+  double sumweights2() const { return cv->sumweights2(); }
+  std::map<int, double> targets_sumweights() const {
+    return cv->targets_sumweights();
+  }
+  double effective_sample_size() const { return cv->effective_sample_size(); }
+  double effective_sample_size(int target_pdg) const {
+    return cv->effective_sample_size(target_pdg);
+  }
+  double fatx_relative_error() const { return cv->fatx_relative_error(); }
+  double fatx_relative_error(int target_pdg) const {
+    return cv->fatx_relative_error(target_pdg);
+  }
+
+  std::string to_string() const;
+
+  std::shared_ptr<Accumulator> clone() const;
+  void merge(Accumulator const &other);
+  void serialise(std::ostream &os) const;
+  void read(std::istream &is);
+
+  int TargetTotalNucleons() const { return cv->TargetTotalNucleons(); }
+  int TargetTotalProtons() const { return cv->TargetTotalProtons(); }
+  int TargetTotalNeutrons() const { return cv->TargetTotalNeutrons(); }
+
+  double TargetAverageA() const { return cv->TargetAverageA(); }
+  double TargetAverageZ() const { return cv->TargetAverageZ(); }
+  double TargetAverageN() const { return cv->TargetAverageN(); }
+
+  Accumulator const &cv_accumulator() const { return *cv; }
+
+private:
+  // the ratio of universe's estimate to the CV estimate
+  double ratio_to_cv(size_t universe) const;
+
+  std::shared_ptr<Accumulator> cv;
+  Method method;
+  std::vector<std::string> names;
+  int cv_index;
+
+  // compensated sums by universe, each a value and its running correction
+  std::vector<double> sumw;
+  std::vector<double> sumw_corr;
+  std::vector<double> recip;
+  std::vector<double> recip_corr;
+  // the E.C.2 reciprocal sum for unit CV weights, used if there is no CV
+  double cv_recip;
+  double cv_recip_corr;
+  // the per-weight cross sections of the last event
+  std::vector<double> last_xsecs;
+};
+
+std::shared_ptr<MultiWeightAccumulator>
+MakeMultiWeightAccumulator(std::shared_ptr<HepMC3::GenRunInfo> gri);
+
+// Reads an accumulator written by Accumulator::serialise, the result can be
+// merged with others of the same type, e.g. to reduce the outputs of many
+// batch jobs without re-reading any events.
+std::shared_ptr<Accumulator> Deserialise(std::istream &is);
+
+// <filename>.fatx
+std::string SummaryFilename(std::string const &filename);
+
+// Saves the state of acc, which has seen every event in filename, to the
+// summary sidecar of filename so that readers can normalise without a pass
+// over the events. The sidecar records the size of filename, so filename must
+// already be closed.
+void WriteSummary(Accumulator const &acc, std::string const &filename);
+// Reads the summary sidecar of filename, returns nullptr if there is none or
+// if it was written for a different version of the file.
+std::shared_ptr<Accumulator> ReadSummary(std::string const &filename);
+
 } // namespace FATX
 
 } // namespace NuHepMC
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "NuHepMC/FDStreams.hxx"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace NuHepMC {
+
+FDStreamBuf::FDStreamBuf(int f, bool own, size_t buffer_size)
+    : fd(f), owned(own), in_buf(buffer_size), out_buf(buffer_size) {
+  if (fd < 0) {
+    throw InvalidFileDescriptor()
+        << "NuHepMC::FDStreamBuf instantiated with file descriptor: " << fd;
+  }
+  setp(out_buf.data(), out_buf.data() + out_buf.size());
+}
+
+FDStreamBuf::~FDStreamBuf() {
+  sync();
+  if (owned) {
+    ::close(fd);
+  }
+}
+
+bool FDStreamBuf::write_all(char const *data, size_t n) {
+  while (n) {
+    ssize_t nwritten = ::write(fd, data, n);
+    if (nwritten < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += nwritten;
+    n -= size_t(nwritten);
+  }
+  return true;
+}
+
+FDStreamBuf::int_type FDStreamBuf::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  ssize_t nread;
+  do {
+    nread = ::read(fd, in_buf.data(), in_buf.size());
+  } while ((nread < 0) && (errno == EINTR));
+
+  if (nread <= 0) {
+    return traits_type::eof();
+  }
+  setg(in_buf.data(), in_buf.data(), in_buf.data() + nread);
+  return traits_type::to_int_type(*gptr());
+}
+
+FDStreamBuf::int_type FDStreamBuf::overflow(int_type ch) {
+  if (!write_all(pbase(), size_t(pptr() - pbase()))) {
+    return traits_type::eof();
+  }
+  setp(out_buf.data(), out_buf.data() + out_buf.size());
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+int FDStreamBuf::sync() {
+  if (pptr() == pbase()) {
+    return 0;
+  }
+  bool ok = write_all(pbase(), size_t(pptr() - pbase()));
+  setp(out_buf.data(), out_buf.data() + out_buf.size());
+  return ok ? 0 : -1;
+}
+
+} // namespace NuHepMC
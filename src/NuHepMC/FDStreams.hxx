@@ -0,0 +1,55 @@
+#pragma once
+
+#include "NuHepMC/Exceptions.hxx"
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace NuHepMC {
+
+// A streambuf over a POSIX file descriptor, such as a pipe, a socket, or
+// stdin/stdout, that can only be read or written through once.
+class FDStreamBuf : public std::streambuf {
+  int fd;
+  bool owned;
+  std::vector<char> in_buf;
+  std::vector<char> out_buf;
+
+  bool write_all(char const *data, size_t n);
+
+protected:
+  int_type underflow();
+  int_type overflow(int_type ch);
+  int sync();
+
+public:
+  NEW_NuHepMC_EXCEPT(InvalidFileDescriptor);
+
+  // if owned, fd is closed when the streambuf is destroyed
+  FDStreamBuf(int fd, bool owned = false, size_t buffer_size = 1 << 16);
+  ~FDStreamBuf();
+};
+
+class FDIStream : public std::istream {
+  FDStreamBuf buf;
+
+public:
+  FDIStream(int fd, bool owned = false)
+      : std::istream(nullptr), buf(fd, owned) {
+    rdbuf(&buf);
+  }
+};
+
+class FDOStream : public std::ostream {
+  FDStreamBuf buf;
+
+public:
+  FDOStream(int fd, bool owned = false)
+      : std::ostream(nullptr), buf(fd, owned) {
+    rdbuf(&buf);
+  }
+};
+
+} // namespace NuHepMC
@@ -0,0 +1,193 @@
+#include "NuHepMC/FlatEvent.hxx"
+
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NuHepMC {
+
+namespace {
+
+// the reductions keep this many independent partial results so that the
+// compiler can map them onto vector lanes without reordering additions
+constexpr size_t kLanes = 4;
+
+// Calls f with the cheapest predicate, f(size_t i) -> bool, that selects the
+// particles with part_status (0 for any) and a PDG code in PDGs
+template <typename F>
+auto WithMatcher(FlatEvent const &fe, int part_status, PDGSet const &PDGs,
+                 F &&f) {
+  int const *st = fe.status.data();
+  int const *pid = fe.pid.data();
+  if (PDGs.empty()) {
+    if (!part_status) {
+      return f([](size_t) { return true; });
+    }
+    return f([=](size_t i) { return st[i] == part_status; });
+  }
+  return f([=, &PDGs](size_t i) {
+    return (!part_status || (st[i] == part_status)) && PDGs.contains(pid[i]);
+  });
+}
+
+// the largest |p|^2 of the selected particles, or -1 if none are selected
+template <typename Match>
+double MaxP3Mod2(FlatEvent const &fe, Match const &match) {
+  size_t const n = fe.size();
+  double const *x = fe.px.data();
+  double const *y = fe.py.data();
+  double const *z = fe.pz.data();
+
+  double best[kLanes];
+  std::fill(best, best + kLanes, -1);
+
+  size_t i = 0;
+  for (; (i + kLanes) <= n; i += kLanes) {
+    for (size_t l = 0; l < kLanes; ++l) {
+      size_t j = i + l;
+      double p2 = (x[j] * x[j]) + (y[j] * y[j]) + (z[j] * z[j]);
+      best[l] = std::max(best[l], match(j) ? p2 : -1.0);
+    }
+  }
+  for (; i < n; ++i) {
+    double p2 = (x[i] * x[i]) + (y[i] * y[i]) + (z[i] * z[i]);
+    best[0] = std::max(best[0], match(i) ? p2 : -1.0);
+  }
+  return *std::max_element(best, best + kLanes);
+}
+
+} // namespace
+
+void FlatEvent::fill(HepMC3::GenEvent const &evt) {
+  momentum_unit = evt.momentum_unit();
+
+  auto const &parts = evt.particles();
+  size_t const nparts = parts.size();
+
+  pid.resize(nparts);
+  status.resize(nparts);
+  px.resize(nparts);
+  py.resize(nparts);
+  pz.resize(nparts);
+  e.resize(nparts);
+  mass.resize(nparts);
+  prod_vtx.assign(nparts, -1);
+  end_vtx.assign(nparts, -1);
+
+  for (size_t i = 0; i < nparts; ++i) {
+    auto const &part = parts[i];
+    auto const &mom = part->momentum();
+    pid[i] = part->pid();
+    status[i] = part->status();
+    px[i] = mom.px();
+    py[i] = mom.py();
+    pz[i] = mom.pz();
+    e[i] = mom.e();
+    mass[i] = part->generated_mass();
+  }
+
+  // particle ids are their 1-based positions in the event, so walking the
+  // vertices fills the vertex links without locking any weak pointers
+  auto const &vtxs = evt.vertices();
+  vtx_status.resize(vtxs.size());
+  for (size_t j = 0; j < vtxs.size(); ++j) {
+    vtx_status[j] = vtxs[j]->status();
+    for (auto const &part : vtxs[j]->particles_in()) {
+      end_vtx[part->id() - 1] = int(j);
+    }
+    for (auto const &part : vtxs[j]->particles_out()) {
+      prod_vtx[part->id() - 1] = int(j);
+    }
+  }
+}
+
+size_t FlatEvent::count(int part_status, PDGSet const &PDGs) const {
+  return WithMatcher(*this, part_status, PDGs, [&](auto const &match) {
+    size_t n = 0;
+    for (size_t i = 0; i < size(); ++i) {
+      n += match(i);
+    }
+    return n;
+  });
+}
+
+HepMC3::FourVector FlatEvent::sum_momentum(int part_status,
+                                           PDGSet const &PDGs) const {
+  return WithMatcher(*this, part_status, PDGs, [&](auto const &match) {
+    size_t const n = size();
+    double const *x = px.data();
+    double const *y = py.data();
+    double const *z = pz.data();
+    double const *t = e.data();
+
+    double sx[kLanes] = {}, sy[kLanes] = {}, sz[kLanes] = {}, st[kLanes] = {};
+
+    size_t i = 0;
+    for (; (i + kLanes) <= n; i += kLanes) {
+      for (size_t l = 0; l < kLanes; ++l) {
+        size_t j = i + l;
+        bool sel = match(j);
+        sx[l] += sel ? x[j] : 0.0;
+        sy[l] += sel ? y[j] : 0.0;
+        sz[l] += sel ? z[j] : 0.0;
+        st[l] += sel ? t[j] : 0.0;
+      }
+    }
+    for (; i < n; ++i) {
+      bool sel = match(i);
+      sx[0] += sel ? x[i] : 0.0;
+      sy[0] += sel ? y[i] : 0.0;
+      sz[0] += sel ? z[i] : 0.0;
+      st[0] += sel ? t[i] : 0.0;
+    }
+
+    for (size_t l = 1; l < kLanes; ++l) {
+      sx[0] += sx[l];
+      sy[0] += sy[l];
+      sz[0] += sz[l];
+      st[0] += st[l];
+    }
+    return HepMC3::FourVector(sx[0], sy[0], sz[0], st[0]);
+  });
+}
+
+double FlatEvent::max_momentum(int part_status, PDGSet const &PDGs) const {
+  double p2 = WithMatcher(*this, part_status, PDGs, [&](auto const &match) {
+    return MaxP3Mod2(*this, match);
+  });
+  return (p2 < 0) ? 0 : std::sqrt(p2);
+}
+
+int FlatEvent::highest_momentum(int part_status, PDGSet const &PDGs) const {
+  return WithMatcher(*this, part_status, PDGs, [&](auto const &match) {
+    double best = MaxP3Mod2(*this, match);
+    if (best < 0) {
+      return -1;
+    }
+    for (size_t i = 0; i < size(); ++i) {
+      double p2 = (px[i] * px[i]) + (py[i] * py[i]) + (pz[i] * pz[i]);
+      if (match(i) && (p2 == best)) {
+        return int(i);
+      }
+    }
+    return -1;
+  });
+}
+
+size_t FlatEvent::select(int part_status, PDGSet const &PDGs,
+                         std::vector<int> &out) const {
+  out.clear();
+  WithMatcher(*this, part_status, PDGs, [&](auto const &match) {
+    for (size_t i = 0; i < size(); ++i) {
+      if (match(i)) {
+        out.push_back(int(i));
+      }
+    }
+    return 0;
+  });
+  return out.size();
+}
+
+} // namespace NuHepMC
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "NuHepMC/EventUtils.hxx"
+
+#include "HepMC3/FourVector.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/Units.h"
+
+#include <vector>
+
+namespace NuHepMC {
+
+// A structure-of-arrays copy of the particles in a HepMC3::GenEvent, filled in
+// a single pass, so that kinematic loops run over contiguous arrays instead of
+// chasing shared pointers. Particle i of the flat event is
+// evt.particles()[i]. Momenta are in the units of the event they were filled
+// from. Re-using one FlatEvent by calling fill for each event re-uses its
+// storage.
+class FlatEvent {
+public:
+  FlatEvent() : momentum_unit(HepMC3::Units::MEV) {}
+  explicit FlatEvent(HepMC3::GenEvent const &evt) : FlatEvent() { fill(evt); }
+
+  void fill(HepMC3::GenEvent const &evt);
+
+  size_t size() const { return pid.size(); }
+
+  HepMC3::Units::MomentumUnit momentum_unit;
+
+  std::vector<int> pid;
+  std::vector<int> status;
+  std::vector<double> px;
+  std::vector<double> py;
+  std::vector<double> pz;
+  std::vector<double> e;
+  std::vector<double> mass;
+  // positions into the vertex arrays, -1 if the particle has no such vertex
+  std::vector<int> prod_vtx;
+  std::vector<int> end_vtx;
+
+  // vertex i of the flat event is evt.vertices()[i]
+  std::vector<int> vtx_status;
+
+  // Kernels over the particles with part_status (0 for any) and a PDG code in
+  // PDGs. They are written without branches in their inner loops so that they
+  // can be auto-vectorised.
+  size_t count(int part_status, PDGSet const &PDGs = {}) const;
+  HepMC3::FourVector sum_momentum(int part_status,
+                                  PDGSet const &PDGs = {}) const;
+  // 0 if no particles match
+  double max_momentum(int part_status, PDGSet const &PDGs = {}) const;
+  // the position of the first matching particle with the highest |p|, or -1
+  int highest_momentum(int part_status, PDGSet const &PDGs = {}) const;
+
+  // clears out and fills it with the positions of the matching particles
+  size_t select(int part_status, PDGSet const &PDGs,
+                std::vector<int> &out) const;
+};
+
+} // namespace NuHepMC
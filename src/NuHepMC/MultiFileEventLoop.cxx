@@ -0,0 +1,61 @@
+#include "NuHepMC/MultiFileEventLoop.hxx"
+
+#include <filesystem>
+
+namespace NuHepMC {
+
+std::vector<EventRangeTask>
+PlanEventRangeTasks(std::vector<std::string> const &filenames,
+                    size_t task_size, bool build_indexes) {
+  task_size = std::max(size_t(1), task_size);
+
+  std::vector<EventRangeTask> tasks;
+  for (size_t ifile = 0; ifile < filenames.size(); ++ifile) {
+    auto const &fname = filenames[ifile];
+
+    std::shared_ptr<EventIndex const> idx;
+    if (build_indexes) {
+      idx = std::make_shared<EventIndex>(LoadOrBuildEventIndex(fname));
+    } else if (auto loaded = LoadEventIndex(fname)) {
+      idx = std::make_shared<EventIndex>(std::move(*loaded));
+    }
+
+    if (!idx) {
+      tasks.push_back(EventRangeTask{ifile, 0, 0, nullptr,
+                                     std::filesystem::file_size(fname)});
+      continue;
+    }
+
+    // cut into equal ranges of at most task_size events
+    size_t nranges = (idx->size() + task_size - 1) / task_size;
+    for (size_t r = 0; r < nranges; ++r) {
+      size_t begin = (r * idx->size()) / nranges;
+      size_t end = ((r + 1) * idx->size()) / nranges;
+
+      uint64_t stop = (end < idx->size()) ? idx->event_offsets[end]
+                                          : idx->end_offset;
+      // offsets are into the decompressed stream, scale them to the file
+      double span = double(stop - idx->event_offsets[begin]) /
+                    double(std::max(uint64_t(1), idx->end_offset));
+      tasks.push_back(EventRangeTask{ifile, begin, end, idx,
+                                     uint64_t(span * idx->file_size)});
+    }
+  }
+
+  std::stable_sort(tasks.begin(), tasks.end(),
+                   [](EventRangeTask const &a, EventRangeTask const &b) {
+                     return a.cost > b.cost;
+                   });
+  return tasks;
+}
+
+std::shared_ptr<NuHepMC::Reader> OpenTask(std::string const &filename,
+                                          EventRangeTask const &task) {
+  if (!task.index) {
+    return std::make_shared<NuHepMC::Reader>(filename);
+  }
+  return std::make_shared<NuHepMC::Reader>(
+      OpenEventRangeReader(filename, *task.index, task.begin, task.end));
+}
+
+} // namespace NuHepMC
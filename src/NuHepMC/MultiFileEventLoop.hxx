@@ -0,0 +1,252 @@
+#pragma once
+
+#include "NuHepMC/EventIndex.hxx"
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/Reader.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NuHepMC {
+
+struct MultiFileEventLoopOptions {
+  // 0 uses one worker per hardware thread
+  size_t nthreads = 0;
+  // files with an up to date EventIndex sidecar are split into tasks of about
+  // this many events, files without one are each read whole by one worker
+  size_t task_size = 50000;
+  // build, and save, the EventIndex of every file without one before
+  // starting, at the cost of a scan of each such file
+  bool build_indexes = false;
+  // makes the FATX accumulator for a file from its run info. If empty, no
+  // accumulators are made and every event is passed a weight of 1
+  std::function<std::shared_ptr<FATX::Accumulator>(
+      std::shared_ptr<HepMC3::GenRunInfo>)>
+      make_accumulator = [](std::shared_ptr<HepMC3::GenRunInfo> gri) {
+        return FATX::MakeAccumulator(gri);
+      };
+};
+
+// The events [begin, end) of a file, or the whole file if there is no index
+struct EventRangeTask {
+  size_t file;
+  size_t begin;
+  size_t end;
+  std::shared_ptr<EventIndex const> index;
+  // roughly the number of bytes on disk that the task reads
+  uint64_t cost;
+};
+
+// Splits files into tasks of at most task_size events, ordered from the most
+// to the least costly
+std::vector<EventRangeTask>
+PlanEventRangeTasks(std::vector<std::string> const &filenames,
+                    size_t task_size, bool build_indexes = false);
+
+std::shared_ptr<NuHepMC::Reader> OpenTask(std::string const &filename,
+                                          EventRangeTask const &task);
+
+// Runs an analysis over the events of many files on a pool of worker threads.
+// The files are split into event range tasks that are dealt out to per-worker
+// queues, largest first, and a worker that runs out of tasks steals from the
+// back of another's queue, so a few very large files do not leave most of the
+// workers idle.
+//
+// Each worker keeps its own analysis state, and every task its own FATX
+// accumulator, as the normalisation differs per file. Once every task is done
+// the accumulators of each file are merged in the order of their events, so
+// that estimates taken from the last event of a file, as for E.C.4, are those
+// of a serial read. Unlike EventLoop, the order in which events are passed to
+// func is not fixed, so merged analysis states may differ in the last few bits
+// of floating point sums from run to run.
+class MultiFileEventLoop {
+  std::vector<std::string> filenames;
+  MultiFileEventLoopOptions opts;
+
+  std::vector<std::shared_ptr<FATX::Accumulator>> accs;
+  size_t nevents;
+  size_t ntasks;
+
+public:
+  NEW_NuHepMC_EXCEPT(NoFiles);
+
+  MultiFileEventLoop(std::vector<std::string> const &files,
+                     MultiFileEventLoopOptions options =
+                         MultiFileEventLoopOptions())
+      : filenames(files), opts(options), nevents(0), ntasks(0) {
+    if (filenames.empty()) {
+      throw NoFiles()
+          << "NuHepMC::MultiFileEventLoop instantiated with no files.";
+    }
+  }
+
+  // Calls func(HepMC3::GenEvent const &evt, double w, State &state,
+  // size_t ifile) for every event in every file, where ifile is the position
+  // of the event's file in the list and w is the CV weight returned by the
+  // accumulator for that file. func is called concurrently from many threads,
+  // but never with the same state object.
+  //
+  // Each worker starts from a copy of initial, and they are combined into the
+  // result by merge(State &into, State const &worker).
+  template <typename State, typename Func, typename Merge>
+  State run(State const &initial, Func &&func, Merge &&merge);
+
+  // The merged accumulator of every event read from file ifile by the last
+  // call to run, nullptr if no events were read from it
+  std::shared_ptr<FATX::Accumulator> accumulator(size_t ifile) const {
+    return accs.at(ifile);
+  }
+  // the number of events processed by the last call to run
+  size_t events() const { return nevents; }
+  // the number of tasks that the files were split into by the last call to
+  // run
+  size_t tasks() const { return ntasks; }
+};
+
+template <typename State, typename Func, typename Merge>
+State MultiFileEventLoop::run(State const &initial, Func &&func,
+                              Merge &&merge) {
+
+  size_t const nthreads =
+      opts.nthreads ? opts.nthreads
+                    : std::max(size_t(1),
+                               size_t(std::thread::hardware_concurrency()));
+
+  auto const tasks =
+      PlanEventRangeTasks(filenames, opts.task_size, opts.build_indexes);
+  ntasks = tasks.size();
+
+  struct TaskQueue {
+    std::mutex mtx;
+    std::deque<size_t> tasks;
+  };
+  std::vector<TaskQueue> queues(nthreads);
+  // dealing the most costly tasks first starts each worker on a big one
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    queues[i % nthreads].tasks.push_back(i);
+  }
+
+  // a worker takes from the front of its own queue, and steals the smallest
+  // remaining task from the back of another's. No tasks are ever added, so
+  // once every queue is empty there is nothing left to do.
+  auto next_task = [&](size_t iworker, size_t &itask) {
+    for (size_t k = 0; k < nthreads; ++k) {
+      auto &q = queues[(iworker + k) % nthreads];
+      std::lock_guard<std::mutex> lock(q.mtx);
+      if (q.tasks.empty()) {
+        continue;
+      }
+      if (!k) {
+        itask = q.tasks.front();
+        q.tasks.pop_front();
+      } else {
+        itask = q.tasks.back();
+        q.tasks.pop_back();
+      }
+      return true;
+    }
+    return false;
+  };
+
+  struct Worker {
+    State state;
+    size_t nevents;
+  };
+  std::vector<Worker> workers_state(nthreads, Worker{initial, 0});
+  // only touched by the worker running the task
+  std::vector<std::shared_ptr<FATX::Accumulator>> task_accs(tasks.size());
+
+  std::atomic<bool> abort(false);
+  std::mutex error_mtx;
+  std::exception_ptr error;
+
+  auto work = [&](size_t iworker) {
+    auto &me = workers_state[iworker];
+    try {
+      HepMC3::GenEvent evt;
+      size_t itask = 0;
+      while (!abort && next_task(iworker, itask)) {
+        auto const &task = tasks[itask];
+        auto rdr = OpenTask(filenames[task.file], task);
+
+        auto &acc = task_accs[itask];
+        if (opts.make_accumulator) {
+          acc = opts.make_accumulator(rdr->run_info());
+        }
+
+        while (!abort) {
+          rdr->read_event(evt);
+          if (rdr->failed()) {
+            break;
+          }
+          double w = acc ? acc->process(evt) : 1;
+          func(evt, w, me.state, task.file);
+          me.nevents++;
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mtx);
+      if (!error) {
+        error = std::current_exception();
+      }
+      abort = true;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < nthreads; ++i) {
+    workers.emplace_back(work, i);
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  State result = initial;
+  nevents = 0;
+  for (auto &w : workers_state) {
+    merge(result, w.state);
+    nevents += w.nevents;
+  }
+
+  // the ranges of a file do not overlap, so ordering by their first event
+  // merges the accumulators of each file in event order
+  std::vector<size_t> order(tasks.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return (tasks[a].file != tasks[b].file) ? (tasks[a].file < tasks[b].file)
+                                            : (tasks[a].begin < tasks[b].begin);
+  });
+
+  accs.assign(filenames.size(), nullptr);
+  for (size_t itask : order) {
+    auto const &acc = task_accs[itask];
+    if (!acc || !acc->events()) {
+      continue;
+    }
+    auto &file_acc = accs[tasks[itask].file];
+    if (!file_acc) {
+      file_acc = acc;
+    } else {
+      file_acc->merge(*acc);
+    }
+  }
+
+  return result;
+}
+
+} // namespace NuHepMC
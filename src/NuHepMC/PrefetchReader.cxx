@@ -0,0 +1,136 @@
+#include "NuHepMC/PrefetchReader.hxx"
+
+namespace NuHepMC {
+
+PrefetchReader::PrefetchReader(std::shared_ptr<NuHepMC::Reader> other,
+                               size_t depth)
+    : rdr(other), ring(depth), ring_head(0), ring_count(0),
+      worker_done(false), stop_requested(false), consumer_failed(false) {
+  if (!rdr) {
+    throw NullReader()
+        << "NuHepMC::PrefetchReader instantiated with a nullptr.";
+  }
+  if (!depth) {
+    throw InvalidPrefetchDepth()
+        << "NuHepMC::PrefetchReader requires a prefetch depth of at least 1.";
+  }
+  // the wrapped reader has already peeked the first event, so the run info
+  // is available before the worker starts
+  set_run_info(rdr->run_info());
+  pool = rdr->event_pool();
+  worker = std::thread(&PrefetchReader::decode_loop, this);
+}
+
+PrefetchReader::PrefetchReader(std::string const &filename, size_t depth)
+    : PrefetchReader(std::make_shared<NuHepMC::Reader>(filename), depth) {}
+
+PrefetchReader::~PrefetchReader() { stop_worker(); }
+
+void PrefetchReader::decode_loop() {
+  try {
+    std::unique_ptr<HepMC3::GenEvent> evt;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(ring_mutex);
+        ring_not_full.wait(lock, [this] {
+          return stop_requested || (ring_count < ring.size());
+        });
+        if (stop_requested) {
+          break;
+        }
+      }
+
+      // the expensive part, done without holding the lock
+      rdr->read_event(evt);
+      if (rdr->failed()) {
+        break;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        ring[(ring_head + ring_count) % ring.size()] = std::move(evt);
+        ring_count++;
+      }
+      ring_not_empty.notify_one();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    worker_exception = std::current_exception();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    worker_done = true;
+  }
+  ring_not_empty.notify_all();
+}
+
+bool PrefetchReader::read_event(std::unique_ptr<HepMC3::GenEvent> &evt) {
+  if (consumer_failed) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(ring_mutex);
+  ring_not_empty.wait(lock, [this] { return worker_done || ring_count; });
+
+  if (!ring_count) {
+    consumer_failed = true;
+    if (worker_exception) {
+      // only rethrow once, subsequent calls just report failure
+      auto except = worker_exception;
+      worker_exception = nullptr;
+      std::rethrow_exception(except);
+    }
+    return false;
+  }
+
+  std::swap(evt, ring[ring_head]);
+  auto done = std::move(ring[ring_head]);
+  ring_head = (ring_head + 1) % ring.size();
+  ring_count--;
+  lock.unlock();
+  ring_not_full.notify_one();
+  pool->release(std::move(done));
+
+  return true;
+}
+
+bool PrefetchReader::read_event(HepMC3::GenEvent &evt) {
+  std::unique_ptr<HepMC3::GenEvent> ready;
+  if (!read_event(ready)) {
+    return false;
+  }
+  evt = *ready;
+
+  // hand the slot straight back to the worker
+  pool->release(std::move(ready));
+  return true;
+}
+
+bool PrefetchReader::skip(const int n) {
+  std::unique_ptr<HepMC3::GenEvent> evt;
+  for (int i = 0; i < n; ++i) {
+    if (!read_event(evt)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrefetchReader::stop_worker() {
+  {
+    std::lock_guard<std::mutex> lock(ring_mutex);
+    stop_requested = true;
+  }
+  ring_not_full.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void PrefetchReader::close() {
+  stop_worker();
+  rdr->close();
+}
+
+} // namespace NuHepMC
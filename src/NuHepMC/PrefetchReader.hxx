@@ -0,0 +1,71 @@
+#pragma once
+
+#include "NuHepMC/Reader.hxx"
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NuHepMC {
+
+// A reader that decodes events, including any NuHepMC spec migration, on a
+// background thread into a bounded ring of ready events, so that parsing and
+// decompression overlap with whatever the caller does with each event.
+class PrefetchReader : public HepMC3::Reader {
+
+  std::shared_ptr<NuHepMC::Reader> rdr;
+
+  // ring of decoded events waiting to be handed to the consumer
+  std::vector<std::unique_ptr<HepMC3::GenEvent>> ring;
+  size_t ring_head;
+  size_t ring_count;
+
+  // events handed back by the consumer that the worker can decode into again,
+  // shared with rdr
+  std::shared_ptr<EventPool> pool;
+
+  std::mutex ring_mutex;
+  std::condition_variable ring_not_full;
+  std::condition_variable ring_not_empty;
+
+  bool worker_done;
+  bool stop_requested;
+  bool consumer_failed;
+  std::exception_ptr worker_exception;
+
+  std::thread worker;
+
+  void decode_loop();
+  void stop_worker();
+
+public:
+  NEW_NuHepMC_EXCEPT(NullReader);
+  NEW_NuHepMC_EXCEPT(InvalidPrefetchDepth);
+
+  // depth is the maximum number of decoded events held ahead of the consumer
+  PrefetchReader(std::shared_ptr<NuHepMC::Reader> other, size_t depth = 16);
+  PrefetchReader(std::string const &filename, size_t depth = 16);
+
+  ~PrefetchReader();
+
+  // Swaps the next decoded event into evt without copying it. Whatever evt
+  // held before the call is handed back to the worker thread to be decoded
+  // into again. Events kept back from the loop can be handed back later
+  // through event_pool().
+  bool read_event(std::unique_ptr<HepMC3::GenEvent> &evt);
+
+  // HepMC3::Reader interface, copies the next decoded event into evt. Prefer
+  // the std::unique_ptr overload in hot loops.
+  bool read_event(HepMC3::GenEvent &evt);
+
+  std::shared_ptr<EventPool> event_pool() const { return pool; }
+
+  bool skip(const int n);
+  bool failed() { return consumer_failed; }
+  void close();
+};
+
+} // namespace NuHepMC
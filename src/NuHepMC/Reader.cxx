@@ -1,5 +1,16 @@
 #include "NuHepMC/Reader.hxx"
 #include "NuHepMC/AttributeUtils.hxx"
+#include "NuHepMC/CompressedStreams.hxx"
+#include "NuHepMC/FDStreams.hxx"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "HepMC3/ReaderAscii.h"
+#include "HepMC3/ReaderAsciiHepMC2.h"
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+#include <fstream>
 
 namespace NuHepMC {
 
@@ -77,43 +88,181 @@ void update_runinfo(std::shared_ptr<HepMC3::GenRunInfo> gri, int in_version) {
 }
 
 template <typename AT>
-void UpdateEventAttributeName(HepMC3::GenEvent &evt,
-                              std::string const &old_name,
-                              std::string const &new_name) {
-
-  if (HasAttributeOfType<AT>(&evt, old_name)) {
-    evt.add_attribute(
-        new_name,
-        evt.attribute<typename NuHepMC::attr_traits<AT>::type>(old_name));
+EventMigrationStep RenameEventAttribute(std::string const &old_name,
+                                        std::string const &new_name) {
+  return [=](HepMC3::GenEvent &evt) {
+    // a single lookup, returns nullptr if the attribute is not there
+    auto attr =
+        evt.attribute<typename NuHepMC::attr_traits<AT>::type>(old_name);
+    if (!attr) {
+      return false;
+    }
+    evt.add_attribute(new_name, attr);
     evt.remove_attribute(old_name);
-  }
+    return true;
+  };
 }
 
-void update_event_090_to_100(HepMC3::GenEvent &evt) {
-  UpdateEventAttributeName<std::vector<double>>(evt, "LabPos", "lab_pos");
-  UpdateEventAttributeName<double>(evt, "TotXS", "tot_xs");
-  UpdateEventAttributeName<double>(evt, "ProcXS", "proc_xs");
-  UpdateEventAttributeName<int>(evt, "ProcID", "signal_process_id");
+void append_event_migration_090_to_100(EventMigrationPlan &plan) {
+  plan.push_back(
+      RenameEventAttribute<std::vector<double>>("LabPos", "lab_pos"));
+  plan.push_back(RenameEventAttribute<double>("TotXS", "tot_xs"));
+  plan.push_back(RenameEventAttribute<double>("ProcXS", "proc_xs"));
+  plan.push_back(RenameEventAttribute<int>("ProcID", "signal_process_id"));
 }
 
-void update_event(HepMC3::GenEvent &evt, int in_version) {
+EventMigrationPlan BuildEventMigrationPlan(int in_version) {
+  EventMigrationPlan plan;
   if (in_version < 10000) {
-    update_event_090_to_100(evt);
+    append_event_migration_090_to_100(plan);
   }
+  // steps for future spec versions are appended here, in order
+  return plan;
 }
 
-bool Reader::read_event(HepMC3::GenEvent &evt) {
+// Decompresses the stream based on its magic bytes and picks the ASCII
+// reader from its first few lines, reading the stream only once
+std::shared_ptr<HepMC3::Reader>
+deduce_reader(std::shared_ptr<std::istream> stream) {
+  auto peeked = Compression::Peek(Compression::OpenDecompressed(stream), 256);
+  if (peeked.first.find("IO_GenEvent") != std::string::npos) {
+    return std::make_shared<HepMC3::ReaderAsciiHepMC2>(peeked.second);
+  }
+  return std::make_shared<HepMC3::ReaderAscii>(peeked.second);
+}
+
+// HepMC3 cannot open zstd files or stdin itself, so those are read here and
+// everything else is left to HepMC3::deduce_reader
+std::shared_ptr<HepMC3::Reader> deduce_reader(std::string const &fname) {
+  if (fname == "-") {
+    return deduce_reader(std::make_shared<FDIStream>(0));
+  }
+  if (Compression::DetectFormat(fname) == Compression::Format::kZstd) {
+    return deduce_reader(
+        std::make_shared<std::ifstream>(fname, std::ios::binary));
+  }
+  return HepMC3::deduce_reader(fname);
+}
+
+Reader::Reader(std::shared_ptr<HepMC3::Reader> other)
+    : rdr(other), in_version(0), nevents_migrated(0),
+      pool(std::make_shared<EventPool>()),
+      peeked_momentum_unit(HepMC3::Units::GEV),
+      peeked_length_unit(HepMC3::Units::MM), summary_read(false) {
+  if (!rdr) {
+    throw NullReader() << "NuHepMC::Reader instantiated with a nullptr.";
+  }
+
+  peeked_evt = pool->acquire();
+  read_and_update(*peeked_evt);
+  if (rdr->failed()) {
+    pool->release(std::move(peeked_evt));
+    return;
+  }
+  peeked_momentum_unit = peeked_evt->momentum_unit();
+  peeked_length_unit = peeked_evt->length_unit();
+}
+
+Reader::Reader(std::string const &fname)
+    : Reader(deduce_reader(fname)) {
+  if (fname != "-") {
+    filename = fname;
+  }
+}
+
+Reader::Reader(std::shared_ptr<std::istream> stream)
+    : Reader(deduce_reader(stream)) {}
+
+bool Reader::read_and_update(HepMC3::GenEvent &evt) {
   bool rdr_rval = rdr->read_event(evt);
 
-  if (!run_info()) {
-    update_runinfo(rdr->run_info(), get_in_version(rdr->run_info()));
+  if (!run_info() && rdr->run_info()) {
+    in_version = get_in_version(rdr->run_info());
+    update_runinfo(rdr->run_info(), in_version);
+    migration_plan = BuildEventMigrationPlan(in_version);
     set_run_info(rdr->run_info());
   }
 
-  update_event(evt, in_version);
+  // files written against the current spec have an empty plan
+  if (migration_plan.size()) {
+    bool migrated = false;
+    for (auto const &step : migration_plan) {
+      migrated = step(evt) || migrated;
+    }
+    if (migrated) {
+      nevents_migrated++;
+    }
+  }
   evt.set_run_info(run_info());
 
-  return rdr_rval;
+  // HepMC3 readers return true from the read that runs off the end of a file
+  return rdr_rval && !rdr->failed();
+}
+
+bool Reader::read_event(HepMC3::GenEvent &evt) {
+  if (peeked_evt) {
+    // the peeked event is not needed again, so it is moved out rather than
+    // copied wherever HepMC3::GenEvent supports it
+    evt = std::move(*peeked_evt);
+    pool->release(std::move(peeked_evt));
+    return true;
+  }
+  return read_and_update(evt);
+}
+
+bool Reader::read_event(std::unique_ptr<HepMC3::GenEvent> &evt) {
+  if (peeked_evt) {
+    pool->release(std::move(evt));
+    evt = std::move(peeked_evt);
+    return true;
+  }
+  if (!evt) {
+    evt = pool->acquire();
+  }
+  return read_and_update(*evt);
+}
+
+bool Reader::skip(const int n) {
+  if ((n > 0) && peeked_evt) {
+    pool->release(std::move(peeked_evt));
+    return (n == 1) ? true : rdr->skip(n - 1);
+  }
+  return rdr->skip(n);
+}
+
+EventIndex const &Reader::event_index() {
+  if (!index) {
+    if (!filename.size()) {
+      throw NoEventIndex() << "NuHepMC::Reader can only index files that it "
+                              "opened itself, construct it from a filename.";
+    }
+    index = std::make_shared<EventIndex>(LoadOrBuildEventIndex(filename));
+  }
+  return *index;
+}
+
+std::shared_ptr<FATX::Accumulator const> Reader::fatx_summary() {
+  if (!summary_read && filename.size()) {
+    summary = FATX::ReadSummary(filename);
+  }
+  summary_read = true;
+  return summary;
+}
+
+bool Reader::seek(size_t ievt) {
+  return read_range(ievt, event_index().size());
+}
+
+bool Reader::read_range(size_t begin, size_t end) {
+  auto const &idx = event_index();
+  end = std::min(end, idx.size());
+  begin = std::min(begin, end);
+
+  // the run info and migration plan already built from the first event are
+  // kept, only the underlying stream is replaced
+  rdr = OpenEventRangeReader(filename, idx, begin, end);
+  pool->release(std::move(peeked_evt));
+  return begin < end;
 }
 
-} // namespace NuHepMC
\ No newline at end of file
+} // namespace NuHepMC
@@ -8,10 +8,26 @@
 #include "HepMC3/ReaderFactory.h"
 #pragma GCC diagnostic pop
 
+#include "NuHepMC/EventIndex.hxx"
+#include "NuHepMC/EventPool.hxx"
 #include "NuHepMC/Exceptions.hxx"
+#include "NuHepMC/FATXUtils.hxx"
+
+#include <functional>
+#include <istream>
+#include <vector>
 
 namespace NuHepMC {
 
+// A single event-level migration operation, returns true if it modified the
+// event.
+using EventMigrationStep = std::function<bool(HepMC3::GenEvent &)>;
+// The ordered list of operations required to bring an event written against
+// an older NuHepMC version up to the current one. Built once per file.
+using EventMigrationPlan = std::vector<EventMigrationStep>;
+
+EventMigrationPlan BuildEventMigrationPlan(int in_version);
+
 // A reader implementation that can automatically update the NuHepMC spec of
 // a read file so that users of cpputils can just target the latest spec.
 class Reader : public HepMC3::Reader {
@@ -19,22 +35,50 @@ class Reader : public HepMC3::Reader {
   std::shared_ptr<HepMC3::Reader> rdr;
 
   int in_version;
+  EventMigrationPlan migration_plan;
+  size_t nevents_migrated;
+
+  // The first event is read on construction so that the GenRunInfo is
+  // available up front, it is handed back on the first call to read_event.
+  std::unique_ptr<HepMC3::GenEvent> peeked_evt;
+  std::shared_ptr<EventPool> pool;
+  HepMC3::Units::MomentumUnit peeked_momentum_unit;
+  HepMC3::Units::LengthUnit peeked_length_unit;
+
+  // only known when constructed from a filename, required for seeking
+  std::string filename;
+  std::shared_ptr<EventIndex> index;
+  std::shared_ptr<FATX::Accumulator const> summary;
+  bool summary_read;
+
+  bool read_and_update(HepMC3::GenEvent &evt);
 
 public:
   NEW_NuHepMC_EXCEPT(NullReader);
+  NEW_NuHepMC_EXCEPT(NoEventIndex);
 
-  Reader(std::shared_ptr<HepMC3::Reader> other) : rdr(other), in_version(0) {
-    if (!rdr) {
-      throw NullReader() << "NuHepMC::Reader instantiated with a nullptr.";
-    }
-  }
+  Reader(std::shared_ptr<HepMC3::Reader> other);
 
-  Reader(std::string const &filename)
-      : Reader(HepMC3::deduce_reader(filename)) {}
+  // "-" reads from stdin
+  Reader(std::string const &filename);
 
-  bool skip(const int n) { return rdr->skip(n); }
+  // Reads HepMC3 or HepMC2 ASCII from a stream that is only read through
+  // once, so it may be a pipe, see FDIStream. Compression is detected from
+  // the magic bytes at the start of the stream.
+  Reader(std::shared_ptr<std::istream> stream);
+
+  bool skip(const int n);
+  // Returns false once no event could be read, unlike the HepMC3 readers,
+  // which still return true from the read that finds the end of the file.
+  // Loops should check failed() after each read, as for any HepMC3::Reader.
   bool read_event(HepMC3::GenEvent &evt);
-  bool failed() { return rdr->failed(); }
+  // Reads the next event into an event from event_pool() without copying it.
+  // Whatever evt held before the call is released back to the pool, so a loop
+  // over a file re-uses the same event throughout. Events kept back from the
+  // loop can be released to the pool once done with.
+  bool read_event(std::unique_ptr<HepMC3::GenEvent> &evt);
+  std::shared_ptr<EventPool> event_pool() const { return pool; }
+  bool failed() { return peeked_evt ? false : rdr->failed(); }
   void close() { return rdr->close(); }
   void set_options(const std::map<std::string, std::string> &options) {
     rdr->set_options(options);
@@ -42,6 +86,39 @@ public:
   std::map<std::string, std::string> get_options() const {
     return rdr->get_options();
   }
+
+  // The units used by the first event in the file, events are not required to
+  // all use the same units, but they almost always do.
+  HepMC3::Units::MomentumUnit momentum_unit() const {
+    return peeked_momentum_unit;
+  }
+  HepMC3::Units::LengthUnit length_unit() const { return peeked_length_unit; }
+
+  // The NuHepMC version of the input file, encoded as
+  // Major * 10000 + Minor * 100 + Patch
+  int input_version() const { return in_version; }
+  // The number of events read so far that needed any migration
+  size_t events_migrated() const { return nevents_migrated; }
+
+  // The byte offset index of the input file, loaded from the sidecar file or
+  // built with a single scan of the input on first use.
+  EventIndex const &event_index();
+
+  // The FATX accumulator state saved next to the input by a writer made with
+  // WriterOptions::fatx_summary, so that fatx(), sumweights(), and
+  // targets_sumweights() for the whole file are known before reading any
+  // events. nullptr if there is no up to date summary or if this reader was
+  // not constructed from a filename.
+  std::shared_ptr<FATX::Accumulator const> fatx_summary();
+
+  // Positions the reader so that the next call to read_event returns the
+  // event at position ievt in the file. Returns false if there is no such
+  // event.
+  bool seek(size_t ievt);
+  // Restricts the reader to the events at positions [begin, end) in the file,
+  // the reader reports failure once the range is exhausted. Returns false if
+  // the range is empty.
+  bool read_range(size_t begin, size_t end);
 };
 
 } // namespace NuHepMC
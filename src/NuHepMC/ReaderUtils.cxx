@@ -2,10 +2,106 @@
 
 #include "HepMC3/GenParticle.h"
 
-#include <regex>
+#include <algorithm>
+#include <limits>
 
 namespace NuHepMC {
 
+bool TokenizeKey(std::string_view key, KeyTokens &tokens) {
+  static constexpr std::string_view prefix = "NuHepMC.";
+  if (key.substr(0, prefix.size()) != prefix) {
+    return false;
+  }
+
+  size_t i = prefix.size();
+  size_t const section_start = i;
+  while ((i < key.size()) && (key[i] != '.') && (key[i] != '[')) {
+    ++i;
+  }
+  if (i == section_start) {
+    return false;
+  }
+  tokens.section = key.substr(section_start, i - section_start);
+  tokens.has_id = false;
+  tokens.id = 0;
+  tokens.field = std::string_view();
+
+  if ((i < key.size()) && (key[i] == '[')) {
+    ++i;
+    bool negative = (i < key.size()) && (key[i] == '-');
+    if (negative) {
+      ++i;
+    }
+    size_t const digits_start = i;
+    long long id = 0;
+    for (; (i < key.size()) && (key[i] >= '0') && (key[i] <= '9'); ++i) {
+      if (id > ((std::numeric_limits<long long>::max() - 9) / 10)) {
+        return false;
+      }
+      id = (id * 10) + (key[i] - '0');
+    }
+    if ((i == digits_start) || (i == key.size()) || (key[i] != ']')) {
+      return false;
+    }
+    ++i;
+    tokens.has_id = true;
+    tokens.id = negative ? -id : id;
+  }
+
+  if (i == key.size()) {
+    return true;
+  }
+  if ((key[i] != '.') || ((i + 1) == key.size())) {
+    return false;
+  }
+  tokens.field = key.substr(i + 1);
+  return true;
+}
+
+RunInfoKeys
+ClassifyRunInfoKeys(std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
+  RunInfoKeys keys;
+
+  KeyTokens tokens;
+  for (auto const &attn : run_info->attribute_names()) {
+    if (!TokenizeKey(attn, tokens)) {
+      continue;
+    }
+
+    if (tokens.section == "Citations") {
+      // NuHepMC.Citations.<component>.<type>, type may not contain dots or
+      // whitespace
+      if (tokens.has_id) {
+        continue;
+      }
+      size_t dot = tokens.field.find('.');
+      if ((dot == std::string_view::npos) || !dot ||
+          ((dot + 1) == tokens.field.size()) ||
+          (tokens.field.find_first_of(". \t\n\v\f\r", dot + 1) !=
+           std::string_view::npos)) {
+        continue;
+      }
+      keys.citations.push_back({attn, std::string(tokens.field.substr(0, dot)),
+                                std::string(tokens.field.substr(dot + 1))});
+
+    } else if ((tokens.section == "Beam") && tokens.has_id) {
+      bool mono = (tokens.field == "MonoEnergetic.Energy");
+      bool hist = (tokens.field == "Histogram.BinEdges");
+      if (!mono && !hist) {
+        continue;
+      }
+      if (!tokens.id || (tokens.id > std::numeric_limits<int>::max()) ||
+          (tokens.id < std::numeric_limits<int>::min())) {
+        throw GC4::InvalidBeamParticleNumber() << "\"" << attn << "\"";
+      }
+      (mono ? keys.monoenergetic_beams : keys.histogram_beams)
+          .push_back(int(tokens.id));
+    }
+  }
+
+  return keys;
+}
+
 namespace GR2 {
 
 std::tuple<int, int, int>
@@ -38,7 +134,10 @@ ReadConventions(std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
 }
 bool SignalsConvention(std::shared_ptr<HepMC3::GenRunInfo const> run_info,
                        std::string const &Convention) {
-  return ReadConventions(run_info).count(Convention);
+  static AttributeKey<std::vector<std::string>> const key(
+      "NuHepMC.Conventions");
+  auto const &convs = key.value(run_info, std::vector<std::string>{});
+  return std::find(convs.begin(), convs.end(), Convention) != convs.end();
 }
 bool SignalsConventions(std::shared_ptr<HepMC3::GenRunInfo const> run_info,
                         std::vector<std::string> Conventions) {
@@ -191,26 +290,9 @@ ReadAllCitations(std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
 
   CitationData all_citations;
 
-  static std::regex const key_re(R"(NuHepMC\.Citations\.([^\.]+)\.([^\.\s]+))");
-
-  for (auto attn : run_info->attribute_names()) {
-
-    std::smatch matches;
-
-    if (!std::regex_match(attn, matches, key_re)) {
-      continue;
-    }
-
-    if (!matches.ready() || (matches.size() != 3)) {
-      std::cerr << "[ERROR]: When parsing Citation metadata key: " << attn
-                << " expected pattern to match "
-                   "NuHepMC\\.Citations\\.([^\\.]+)\\.([^\\.\\s]+) with 2 "
-                   "sub_matches, but found: "
-                << (matches.size() - 1) << std::endl;
-    }
-
-    all_citations[matches[1]][matches[2]] =
-        CheckedAttributeValue<std::string>(run_info, attn);
+  for (auto const &cit : ClassifyRunInfoKeys(run_info).citations) {
+    all_citations[cit.component][cit.type] =
+        CheckedAttributeValue<std::string>(run_info, cit.key);
   }
 
   return all_citations;
@@ -230,28 +312,7 @@ EnergyDistribution ReadMonoEnergeticDistribution(
 
 std::vector<int> FindAllMonoEnergeticDistributionsPDGs(
     std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
-
-  std::vector<int> pdg_numbers;
-
-  static std::regex const key_re(
-      R"(NuHepMC\.Beam\[([0-9]+)\]\.MonoEnergetic\.Energy)");
-
-  for (auto attn : run_info->attribute_names()) {
-
-    std::smatch matches;
-
-    if (!std::regex_match(attn, matches, key_re)) {
-      continue;
-    }
-
-    pdg_numbers.push_back(std::stol(matches[1]));
-
-    if (pdg_numbers.back() == 0) {
-      throw InvalidBeamParticleNumber() << "\"" << matches[1] << "\"";
-    }
-  }
-
-  return pdg_numbers;
+  return ClassifyRunInfoKeys(run_info).monoenergetic_beams;
 }
 
 EnergyDistribution
@@ -279,28 +340,7 @@ ReadHistogramDistribution(std::shared_ptr<HepMC3::GenRunInfo const> run_info,
 
 std::vector<int> FindAllHistogramDistributionsPDGs(
     std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
-
-  std::vector<int> pdg_numbers;
-
-  static std::regex const key_re(
-      R"(NuHepMC\.Beam\[([0-9]+)\]\.Histogram\.BinEdges)");
-
-  for (auto attn : run_info->attribute_names()) {
-
-    std::smatch matches;
-
-    if (!std::regex_match(attn, matches, key_re)) {
-      continue;
-    }
-
-    pdg_numbers.push_back(std::stol(matches[1]));
-
-    if (pdg_numbers.back() == 0) {
-      throw InvalidBeamParticleNumber() << "\"" << matches[1] << "\"";
-    }
-  }
-
-  return pdg_numbers;
+  return ClassifyRunInfoKeys(run_info).histogram_beams;
 }
 
 EnergyDistribution BuildEnergyDistributionTemplate(
@@ -382,8 +422,9 @@ bool HasEnergyDistribution(std::shared_ptr<HepMC3::GenRunInfo const> run_info,
     return false;
   }
 
-  auto monoed = FindAllMonoEnergeticDistributionsPDGs(run_info);
-  auto histed = FindAllHistogramDistributionsPDGs(run_info);
+  auto keys = ClassifyRunInfoKeys(run_info);
+  auto const &monoed = keys.monoenergetic_beams;
+  auto const &histed = keys.histogram_beams;
 
   if (pdg_number == 0) {
     return monoed.size() + histed.size();
@@ -401,25 +442,29 @@ bool HasEnergyDistribution(std::shared_ptr<HepMC3::GenRunInfo const> run_info,
 
 namespace ER3 {
 int ReadProcessID(HepMC3::GenEvent const &evt) {
-  return CheckedAttributeValue<int>(&evt, "signal_process_id");
+  static AttributeKey<int> const key("signal_process_id");
+  return key.value(&evt);
 }
 } // namespace ER3
 
 namespace ER5 {
 std::vector<double> ReadLabPosition(HepMC3::GenEvent const &evt) {
-  return CheckedAttributeValue<std::vector<double>>(&evt, "lab_pos");
+  static AttributeKey<std::vector<double>> const key("lab_pos");
+  return key.value(&evt);
 }
 } // namespace ER5
 
 namespace EC2 {
 double ReadTotalCrossSection(HepMC3::GenEvent const &evt) {
-  return CheckedAttributeValue<double>(&evt, "tot_xs");
+  static AttributeKey<double> const key("tot_xs");
+  return key.value(&evt);
 }
 } // namespace EC2
 
 namespace EC3 {
 double ReadProcessCrossSection(HepMC3::GenEvent const &evt) {
-  return CheckedAttributeValue<double>(&evt, "proc_xs");
+  static AttributeKey<double> const key("proc_xs");
+  return key.value(&evt);
 }
 } // namespace EC3
 
@@ -17,10 +17,44 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace NuHepMC {
 
+// The parts of a run info attribute key of the form
+// NuHepMC.<section>[<id>].<field>, where [<id>] is optional and field may
+// contain further dots. The views point into the tokenized key.
+struct KeyTokens {
+  std::string_view section;
+  bool has_id;
+  long long id;
+  std::string_view field;
+};
+
+// Returns false if key does not follow the grammar above. Never allocates.
+bool TokenizeKey(std::string_view key, KeyTokens &tokens);
+
+// The run info attribute keys that must be searched for rather than looked up
+// by name, classified with a single pass over the attribute names.
+struct RunInfoKeys {
+  // each NuHepMC.Citations.<component>.<type>
+  struct Citation {
+    std::string key;
+    std::string component;
+    std::string type;
+  };
+  std::vector<Citation> citations;
+
+  // the <id>s of each NuHepMC.Beam[<id>].MonoEnergetic.Energy and
+  // NuHepMC.Beam[<id>].Histogram.BinEdges
+  std::vector<int> monoenergetic_beams;
+  std::vector<int> histogram_beams;
+};
+
+RunInfoKeys
+ClassifyRunInfoKeys(std::shared_ptr<HepMC3::GenRunInfo const> run_info);
+
 namespace GR2 {
 std::tuple<int, int, int>
 ReadVersion(std::shared_ptr<HepMC3::GenRunInfo const> run_info);
@@ -0,0 +1,140 @@
+#include "NuHepMC/RunInfoView.hxx"
+
+#include "NuHepMC/AttributeUtils.hxx"
+#include "NuHepMC/ReaderUtils.hxx"
+
+#include <algorithm>
+
+namespace NuHepMC {
+
+IdTable::IdTable(StatusCodeDescriptors const &descriptors) : first(0) {
+  for (auto const &d : descriptors) {
+    codes.push_back(d.first);
+    entries.push_back(d.second);
+  }
+
+  if (!codes.size()) {
+    return;
+  }
+
+  // only use a dense table if it wastes no more than a few slots per code
+  long long range = (long long)(codes.back()) - codes.front() + 1;
+  if (range > (4 * (long long)(codes.size()) + 64)) {
+    return;
+  }
+
+  first = codes.front();
+  slots.assign(size_t(range), -1);
+  for (size_t i = 0; i < codes.size(); ++i) {
+    slots[size_t(codes[i] - first)] = int(i);
+  }
+}
+
+int IdTable::find(int id) const {
+  if (slots.size()) {
+    long long slot = (long long)(id) - first;
+    if ((slot < 0) || (slot >= (long long)(slots.size()))) {
+      return -1;
+    }
+    return slots[size_t(slot)];
+  }
+
+  auto it = std::lower_bound(codes.begin(), codes.end(), id);
+  if ((it == codes.end()) || (*it != id)) {
+    return -1;
+  }
+  return int(it - codes.begin());
+}
+
+std::string const &IdTable::name(int id) const {
+  static std::string const empty;
+  int i = find(id);
+  return (i < 0) ? empty : entries[size_t(i)].first;
+}
+
+std::string const &IdTable::description(int id) const {
+  static std::string const empty;
+  int i = find(id);
+  return (i < 0) ? empty : entries[size_t(i)].second;
+}
+
+StatusCodeDescriptors IdTable::descriptors() const {
+  StatusCodeDescriptors descs;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    descs[codes[i]] = entries[i];
+  }
+  return descs;
+}
+
+std::shared_ptr<RunInfoView const>
+MakeRunInfoView(std::shared_ptr<HepMC3::GenRunInfo const> run_info) {
+  if (!run_info) {
+    throw NullRunInfo() << "MakeRunInfoView passed a null pointer for "
+                           "HepMC3::GenRunInfo";
+  }
+
+  auto view = std::make_shared<RunInfoView>();
+  view->run_info = run_info;
+
+  // fields that the run info does not contain are left empty
+  view->version = HasAttributeOfType<int>(run_info, "NuHepMC.Version.Major")
+                      ? GR2::ReadVersion(run_info)
+                      : std::make_tuple(0, 0, 0);
+
+  for (auto const &c : CheckedAttributeValue<std::vector<std::string>>(
+           run_info, "NuHepMC.Conventions", std::vector<std::string>{})) {
+    int bit = ConventionBit(c.c_str());
+    if (bit >= 0) {
+      view->conventions.set(size_t(bit));
+    } else {
+      view->other_conventions.insert(c);
+    }
+  }
+
+  view->cross_section_units_str = GR6::ReadCrossSectionUnits(run_info);
+  view->cross_section_units =
+      GR6::ParseCrossSectionUnits(view->cross_section_units_str);
+
+  view->cv_weight_index = run_info->weight_index("CV");
+
+  if (HasAttributeOfType<std::vector<int>>(run_info, "NuHepMC.ProcessIDs")) {
+    view->process_ids = IdTable(GR8::ReadProcessIdDefinitions(run_info));
+  }
+  if (HasAttributeOfType<std::vector<int>>(run_info,
+                                           "NuHepMC.VertexStatusIDs")) {
+    view->vertex_status_ids =
+        IdTable(GR9::ReadVertexStatusIdDefinitions(run_info));
+  }
+  if (HasAttributeOfType<std::vector<int>>(run_info,
+                                           "NuHepMC.ParticleStatusIDs")) {
+    view->particle_status_ids =
+        IdTable(GR10::ReadParticleStatusIdDefinitions(run_info));
+  }
+  if (HasAttributeOfType<std::vector<int>>(
+          run_info, "NuHepMC.AdditionalParticleNumbers")) {
+    view->nonstandard_particle_numbers =
+        IdTable(GR11::ReadNonStandardParticleNumbers(run_info));
+  }
+
+  if (HasAttributeOfType<double>(run_info, "NuHepMC.Exposure.POT")) {
+    view->exposure_pot = GC1::ReadExposurePOT(run_info);
+  }
+  if (HasAttributeOfType<double>(run_info, "NuHepMC.Exposure.Livetime")) {
+    view->exposure_livetime = GC1::ReadExposureLivetime(run_info);
+  }
+
+  if (HasAttributeOfType<double>(run_info,
+                                 "NuHepMC.FluxAveragedTotalCrossSection")) {
+    view->fatx = GC2::ReadFluxAveragedTotalXSec(run_info);
+  }
+
+  view->citations = GC3::ReadAllCitations(run_info);
+
+  if (GC4::HasEnergyDistribution(run_info)) {
+    view->energy_distributions = GC4::ReadAllEnergyDistributions(run_info);
+  }
+
+  return view;
+}
+
+} // namespace NuHepMC
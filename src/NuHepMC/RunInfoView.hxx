@@ -0,0 +1,146 @@
+#pragma once
+
+#include "NuHepMC/Types.hxx"
+#include "NuHepMC/UnitsUtils.hxx"
+
+#include "HepMC3/GenRunInfo.h"
+
+#include <bitset>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace NuHepMC {
+
+// The bit for a NuHepMC convention name of the form <X>.C.<N>, where X is one
+// of G, E, V, or P and N is in [1, 32], or -1 for any other name.
+constexpr int ConventionBit(char const *name) {
+  int category = -1;
+  switch (name[0]) {
+  case 'G': {
+    category = 0;
+    break;
+  }
+  case 'E': {
+    category = 1;
+    break;
+  }
+  case 'V': {
+    category = 2;
+    break;
+  }
+  case 'P': {
+    category = 3;
+    break;
+  }
+  default: {
+    return -1;
+  }
+  }
+  if ((name[1] != '.') || (name[2] != 'C') || (name[3] != '.')) {
+    return -1;
+  }
+  int number = 0;
+  char const *c = name + 4;
+  for (; (*c >= '0') && (*c <= '9'); ++c) {
+    number = (number * 10) + (*c - '0');
+    if (number > 32) {
+      return -1;
+    }
+  }
+  if ((c == (name + 4)) || *c || !number) {
+    return -1;
+  }
+  return (category * 32) + (number - 1);
+}
+
+// A code to (name, description) table, stored densely when the codes are
+// compact enough so that lookups are a single array access, and as a sorted
+// array searched by bisection otherwise.
+class IdTable {
+public:
+  IdTable() : first(0) {}
+  explicit IdTable(StatusCodeDescriptors const &descriptors);
+
+  bool has(int id) const { return find(id) >= 0; }
+  // empty strings for unknown codes
+  std::string const &name(int id) const;
+  std::string const &description(int id) const;
+
+  std::vector<int> const &ids() const { return codes; }
+  size_t size() const { return codes.size(); }
+
+  StatusCodeDescriptors descriptors() const;
+
+private:
+  int find(int id) const;
+
+  std::vector<int> codes;
+  std::vector<std::pair<std::string, std::string>> entries;
+
+  // if non-empty, slots[id - first] is the position of id in entries, or -1
+  int first;
+  std::vector<int> slots;
+};
+
+// Every NuHepMC run-level field, parsed once from a HepMC3::GenRunInfo.
+// Instances are built by MakeRunInfoView and handed out as pointers to const,
+// so one view can be shared by any number of threads, which can then query
+// run metadata without any string parsing or attribute lookups.
+struct RunInfoView {
+  std::shared_ptr<HepMC3::GenRunInfo const> run_info;
+
+  // G.R.2
+  std::tuple<int, int, int> version;
+
+  // G.R.4, standard conventions are flagged in conventions at ConventionBit,
+  // any other signalled conventions are listed in other_conventions
+  std::bitset<128> conventions;
+  std::set<std::string> other_conventions;
+
+  bool signals(int convention_bit) const {
+    return (convention_bit >= 0) && conventions.test(size_t(convention_bit));
+  }
+  bool signals(std::string const &convention) const {
+    int bit = ConventionBit(convention.c_str());
+    return (bit >= 0) ? conventions.test(size_t(bit))
+                      : other_conventions.count(convention);
+  }
+
+  // G.R.6
+  std::pair<std::string, std::string> cross_section_units_str;
+  CrossSection::Units::Unit cross_section_units;
+
+  // G.R.7, the position of the CV weight, or -1 if there is none
+  int cv_weight_index = -1;
+
+  // G.R.8 - G.R.11
+  IdTable process_ids;
+  IdTable vertex_status_ids;
+  IdTable particle_status_ids;
+  IdTable nonstandard_particle_numbers;
+
+  // G.C.1
+  std::optional<double> exposure_pot;
+  std::optional<double> exposure_livetime;
+
+  // G.C.2
+  std::optional<double> fatx;
+
+  // G.C.3
+  CitationData citations;
+
+  // G.C.4, keyed by beam particle PDG code
+  std::map<int, GC4::EnergyDistribution> energy_distributions;
+};
+
+NEW_NuHepMC_EXCEPT(NullRunInfo);
+
+std::shared_ptr<RunInfoView const>
+MakeRunInfoView(std::shared_ptr<HepMC3::GenRunInfo const> run_info);
+
+} // namespace NuHepMC
@@ -4,6 +4,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 namespace NuHepMC {
 using StatusCodeDescriptors =
@@ -1,5 +1,10 @@
 #include "NuHepMC/make_writer.hxx"
 
+#include "NuHepMC/AsyncWriter.hxx"
+#include "NuHepMC/CompressedStreams.hxx"
+#include "NuHepMC/EventIndex.hxx"
+#include "NuHepMC/FDStreams.hxx"
+
 #include "NuHepMC/HepMC3Features.hxx"
 
 #include "HepMC3/GenRunInfo.h"
@@ -15,6 +20,8 @@
 #include "HepMC3/Writerprotobuf.h"
 #endif
 
+#include <filesystem>
+
 namespace NuHepMC {
 
 NEW_NuHepMC_EXCEPT(UnsupportedFilenameExtension);
@@ -29,6 +36,7 @@ enum CompressionFormat {
   kZ = 10,
   kLZMA = 20,
   kBZip2 = 30,
+  kZstd = 40,
 };
 
 std::pair<std::string, std::string> split_extension(std::string const &name);
@@ -59,6 +67,8 @@ int ParseExtension(std::string const &name) {
     return kLZMA;
   } else if (ext == "bz2") {
     return kBZip2;
+  } else if ((ext == "zst") || (ext == "zstd")) {
+    return kZstd;
   }
   throw NuHepMC::UnknownFilenameExtension()
       << "Parsed extension: \"" << ext << "\" from filename: \"" << name
@@ -93,8 +103,185 @@ HepMC3::Writer *make_writergz(std::string const &name,
          "type";
 }
 
-HepMC3::Writer *make_writer(std::string const &name,
-                            std::shared_ptr<HepMC3::GenRunInfo> run_info) {
+// A WriterAscii over a ParallelCompressingOStream, which must be finished once
+// the writer is closed for the file to be complete. When seekable, blocks are
+// only cut between events and the offsets of every event and block are
+// written to the EventIndexFilename sidecar on close.
+class ParallelCompressedWriterAscii : public HepMC3::WriterAscii {
+  std::shared_ptr<Compression::ParallelCompressingOStream> stream;
+  std::string filename;
+  bool seekable;
+  EventIndex idx;
+  bool closed;
+
+public:
+  ParallelCompressedWriterAscii(
+      std::shared_ptr<Compression::ParallelCompressingOStream> s,
+      std::string const &fname, Compression::Format fmt, bool skable,
+      std::shared_ptr<HepMC3::GenRunInfo> run_info)
+      : HepMC3::WriterAscii(std::static_pointer_cast<std::ostream>(s),
+                            run_info),
+        stream(s), filename(fname), seekable(skable), closed(false) {
+    idx.format = EventIndex::Format::kAsciiv3;
+    idx.compression = fmt;
+    idx.file_size = 0;
+    idx.header_size = 0;
+    idx.end_offset = 0;
+  }
+  ~ParallelCompressedWriterAscii() {
+    try {
+      close();
+    } catch (...) {
+      // nothing sensible to do about a failed write here
+    }
+  }
+
+  void write_event(HepMC3::GenEvent const &evt) {
+    if (!seekable) {
+      HepMC3::WriterAscii::write_event(evt);
+      return;
+    }
+
+    // every event is flushed through to the stream by the time write_event
+    // returns, so each starts where the last one ended
+    auto &blocks = stream->blocks();
+    uint64_t start = blocks.uncompressed_size();
+    HepMC3::WriterAscii::write_event(evt);
+
+    if (!idx.size()) {
+      // the run info may have been written in front of the first event, the
+      // header is still all in the first block as that is only cut below
+      auto blk = blocks.current_block();
+      size_t pos = size_t(start - blocks.current_block_start());
+      while ((pos < blk.size()) && (blk[pos] != 'E')) {
+        size_t nl = blk.find('\n', pos);
+        pos = (nl == std::string_view::npos) ? blk.size() : (nl + 1);
+      }
+      start = blocks.current_block_start() + pos;
+    }
+    idx.event_offsets.push_back(start);
+    blocks.mark_boundary();
+  }
+
+  bool failed() { return HepMC3::WriterAscii::failed() || !*stream; }
+  void close() {
+    if (closed) {
+      return;
+    }
+    closed = true;
+    idx.end_offset = stream->blocks().uncompressed_size();
+    HepMC3::WriterAscii::close();
+    stream->finish();
+
+    // an empty file is left to be indexed on first use
+    if (seekable && idx.size()) {
+      idx.header_size = idx.event_offsets.front();
+      idx.checkpoints = stream->blocks().block_offsets();
+      idx.file_size = std::filesystem::file_size(filename);
+      WriteEventIndex(idx, EventIndexFilename(filename));
+    }
+  }
+};
+
+HepMC3::Writer *
+make_parallel_compressed_writer(std::string const &name,
+                                std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                                WriterOptions const &opts) {
+  // CompressionFormat and Compression::Format share values
+  auto fmt = Compression::Format(ParseExtension(name));
+  auto stream = Compression::OpenCompressed(
+      name, fmt, opts.compression_threads, opts.compression_block_size,
+      opts.compression_level, !opts.seekable);
+  return new ParallelCompressedWriterAscii(stream, name, fmt, opts.seekable,
+                                           run_info);
+}
+
+// A WriterAscii over a stream that it does not own, which is flushed on close
+// so that everything written has reached, e.g., a pipe before the writer is
+// destroyed
+class StreamWriterAscii : public HepMC3::WriterAscii {
+  std::shared_ptr<std::ostream> stream;
+  bool closed;
+
+public:
+  StreamWriterAscii(std::shared_ptr<std::ostream> s,
+                    std::shared_ptr<HepMC3::GenRunInfo> run_info)
+      : HepMC3::WriterAscii(s, run_info), stream(s), closed(false) {}
+  ~StreamWriterAscii() {
+    try {
+      close();
+    } catch (...) {
+      // nothing sensible to do about a failed write here
+    }
+  }
+
+  bool failed() { return HepMC3::WriterAscii::failed() || !*stream; }
+  void close() {
+    if (closed) {
+      return;
+    }
+    closed = true;
+    HepMC3::WriterAscii::close();
+    stream->flush();
+  }
+};
+
+HepMC3::Writer *make_stream_writer(std::shared_ptr<std::ostream> stream,
+                                   std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                                   Compression::Format compression,
+                                   WriterOptions const &opts) {
+  if (opts.fatx_summary || opts.seekable) {
+    throw NuHepMC::UnsupportedWriterOption()
+        << "WriterOptions::fatx_summary and WriterOptions::seekable write "
+           "sidecar files, and so cannot be used when writing to a stream.";
+  }
+  if (compression == Compression::Format::kNone) {
+    return new StreamWriterAscii(stream, run_info);
+  }
+  auto cstream = std::make_shared<Compression::ParallelCompressingOStream>(
+      stream, compression, opts.compression_threads,
+      opts.compression_block_size, opts.compression_level);
+  return new ParallelCompressedWriterAscii(cstream, "", compression, false,
+                                           run_info);
+}
+
+template <bxz::Compression C>
+HepMC3::Writer *make_compressed_writer(
+    std::string const &name, std::shared_ptr<HepMC3::GenRunInfo> run_info,
+    WriterOptions const &opts) {
+  if (ParseExtension(split_extension(name).first) == kHepMC3) {
+    return make_parallel_compressed_writer(name, run_info, opts);
+  }
+  if (opts.seekable) {
+    throw NuHepMC::UnsupportedFilenameExtension()
+        << "Seekable compressed output is only supported for HepMC3 ascii "
+           "output, but it was requested for output file: "
+        << name;
+  }
+  return make_writergz<C>(name, run_info);
+}
+
+HepMC3::Writer *make_base_writer(std::string const &name,
+                                 std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                                 WriterOptions const &opts) {
+
+  // "-" writes ASCII to stdout, and "-.gz", "-.zst" etc. compress it. The
+  // format may also be named, as in "-.hepmc3.gz", but it must be ASCII.
+  if ((name == "-") || (name.rfind("-.", 0) == 0)) {
+    int ext = (name == "-") ? kHepMC3 : ParseExtension(name);
+    std::string fmt_name = (ext >= kZ) ? split_extension(name).first : name;
+    if ((fmt_name != "-") && (ParseExtension(fmt_name) != kHepMC3)) {
+      throw NuHepMC::UnsupportedFilenameExtension()
+          << "Only HepMC3 ascii can be written to stdout, but the output file "
+             "was: "
+          << name;
+    }
+    return make_stream_writer(
+        std::make_shared<FDOStream>(1), run_info,
+        (ext == kHepMC3) ? Compression::Format::kNone
+                         : Compression::Format(ext),
+        opts);
+  }
 
   int ext = ParseExtension(name);
 
@@ -116,7 +303,8 @@ HepMC3::Writer *make_writer(std::string const &name,
            "writer for output file: "
         << name;
 #else
-    return make_writergz<bxz::Compression::z>(name, run_info);
+    return make_compressed_writer<bxz::Compression::z>(name, run_info,
+                                                       opts);
 #endif
 
   } else if (((ext / 10) * 10) == kLZMA) {
@@ -126,7 +314,8 @@ HepMC3::Writer *make_writer(std::string const &name,
            "writer for output file: "
         << name;
 #else
-    return make_writergz<bxz::Compression::lzma>(name, run_info);
+    return make_compressed_writer<bxz::Compression::lzma>(name, run_info,
+                                                       opts);
 #endif
 
   } else if (((ext / 10) * 10) == kBZip2) {
@@ -136,7 +325,26 @@ HepMC3::Writer *make_writer(std::string const &name,
            "writer for output file: "
         << name;
 #else
-    return make_writergz<bxz::Compression::bz2>(name, run_info);
+    return make_compressed_writer<bxz::Compression::bz2>(name, run_info,
+                                                       opts);
+#endif
+
+  } else if (((ext / 10) * 10) == kZstd) {
+#if HEPMC3_ZSTD_SUPPORT != 1
+    throw NuHepMC::UnsupportedFilenameExtension()
+        << "NuHepMC_CPPUtils built without zstd support but tried to "
+           "instantiate a writer for output file: "
+        << name;
+#else
+    // HepMC3 has no zstd streams of its own, so only the ascii format that
+    // we can compress ourselves is available
+    if (ParseExtension(split_extension(name).first) != kHepMC3) {
+      throw NuHepMC::UnsupportedFilenameExtension()
+          << "zstd compression is only supported for HepMC3 ascii output, "
+             "but tried to instantiate a writer for output file: "
+          << name;
+    }
+    return make_parallel_compressed_writer(name, run_info, opts);
 #endif
   }
   throw NuHepMC::UnknownFilenameExtension()
@@ -145,5 +353,76 @@ HepMC3::Writer *make_writer(std::string const &name,
       << "\", could not automatically determine HepMC3::Writer concrete "
          "type";
 }
+
+HepMC3::Writer *make_writer(std::string const &name,
+                            std::shared_ptr<HepMC3::GenRunInfo> run_info) {
+  return make_writer(name, run_info, WriterOptions());
+}
+
+HepMC3::Writer *make_writer(std::string const &name,
+                            std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                            WriterOptions const &opts) {
+  auto wrtr = make_base_writer(name, run_info, opts);
+  if (opts.fatx_summary) {
+    wrtr = new FATXSummaryWriter(
+        wrtr, name, run_info ? FATX::MakeAccumulator(run_info) : nullptr);
+  }
+  if (opts.async) {
+    wrtr = new AsyncWriter(std::shared_ptr<HepMC3::Writer>(wrtr),
+                           opts.async_depth);
+  }
+  return wrtr;
+}
+
+HepMC3::Writer *make_writer(std::shared_ptr<std::ostream> stream,
+                            std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                            Compression::Format compression,
+                            WriterOptions const &opts) {
+  auto wrtr = make_stream_writer(stream, run_info, compression, opts);
+  if (opts.async) {
+    wrtr = new AsyncWriter(std::shared_ptr<HepMC3::Writer>(wrtr),
+                           opts.async_depth);
+  }
+  return wrtr;
+}
+
+FATXSummaryWriter::FATXSummaryWriter(HepMC3::Writer *writer,
+                                     std::string const &fname,
+                                     std::shared_ptr<FATX::Accumulator> a)
+    : wrtr(writer), filename(fname), acc(a), closed(false) {
+  if (!wrtr) {
+    throw NullWriter()
+        << "NuHepMC::Writer::FATXSummaryWriter instantiated with a nullptr.";
+  }
+  HepMC3::Writer::set_run_info(wrtr->run_info());
+}
+
+FATXSummaryWriter::~FATXSummaryWriter() {
+  try {
+    close();
+  } catch (...) {
+    // nothing sensible to do about a failed summary write here
+  }
+}
+
+void FATXSummaryWriter::write_event(HepMC3::GenEvent const &evt) {
+  if (!acc) {
+    acc = FATX::MakeAccumulator(evt.run_info() ? evt.run_info() : run_info());
+  }
+  acc->process(evt);
+  wrtr->write_event(evt);
+}
+
+void FATXSummaryWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+  wrtr->close();
+  if (acc) {
+    FATX::WriteSummary(*acc, filename);
+  }
+}
+
 } // namespace Writer
-} // namespace NuHepMC
\ No newline at end of file
+} // namespace NuHepMC
@@ -2,20 +2,99 @@
 
 #include "NuHepMC/HepMC3Features.hxx"
 
+#include "NuHepMC/CompressedStreams.hxx"
 #include "NuHepMC/Exceptions.hxx"
+#include "NuHepMC/FATXUtils.hxx"
 
 #include "HepMC3/GenRunInfo.h"
 #include "HepMC3/Writer.h"
 
+#include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 
 namespace NuHepMC {
 
+NEW_NuHepMC_EXCEPT(UnsupportedWriterOption);
+
 namespace Writer {
 
+struct WriterOptions {
+  // feed every written event to a FATX accumulator and save its state to the
+  // FATX::SummaryFilename sidecar of the output on close
+  bool fatx_summary = false;
+  // serialise and compress events on a background thread, see AsyncWriter
+  bool async = false;
+  // the maximum number of events queued ahead of the background thread
+  size_t async_depth = 16;
+
+  // .hepmc3.gz/.bz2/.lzma/.zst outputs are cut into independent blocks of
+  // compression_block_size bytes that are compressed on compression_threads
+  // threads, 0 uses one per hardware core. compression_level is 1 - 9 (1 - 22
+  // for zstd), or -1 for the library default.
+  size_t compression_threads = 0;
+  size_t compression_block_size = 4 << 20;
+  int compression_level = -1;
+  // compressed ascii outputs only cut blocks between events and write an
+  // EventIndex sidecar on close, so that NuHepMC::Reader::read_range can start
+  // decompressing at the block holding the first requested event
+  bool seekable = false;
+};
+
 HepMC3::Writer *
 make_writer(std::string const &name,
             std::shared_ptr<HepMC3::GenRunInfo> run_info = nullptr);
+HepMC3::Writer *make_writer(std::string const &name,
+                            std::shared_ptr<HepMC3::GenRunInfo> run_info,
+                            WriterOptions const &opts);
+
+// Writes HepMC3 ASCII to stream, such as an FDOStream over a pipe, compressed
+// with compression unless it is kNone. A name of "-" (or "-.gz", "-.zst",
+// etc.) passed to the other overloads writes to stdout in the same way.
+// fatx_summary and seekable need a file next to which to write their sidecars
+// and cannot be used.
+HepMC3::Writer *
+make_writer(std::shared_ptr<std::ostream> stream,
+            std::shared_ptr<HepMC3::GenRunInfo> run_info,
+            Compression::Format compression = Compression::Format::kNone,
+            WriterOptions const &opts = WriterOptions());
+
+// Wraps a writer for the file filename, passing each written event to a FATX
+// accumulator, and writes the accumulator to the summary sidecar of filename
+// once the wrapped writer has been closed. The accumulator is built from the
+// run info on the first event if one is not passed.
+class FATXSummaryWriter : public HepMC3::Writer {
+  std::unique_ptr<HepMC3::Writer> wrtr;
+  std::string filename;
+  std::shared_ptr<FATX::Accumulator> acc;
+  bool closed;
+
+public:
+  NEW_NuHepMC_EXCEPT(NullWriter);
+
+  FATXSummaryWriter(HepMC3::Writer *writer, std::string const &filename,
+                    std::shared_ptr<FATX::Accumulator> acc = nullptr);
+  ~FATXSummaryWriter();
+
+  void write_event(HepMC3::GenEvent const &evt);
+  bool failed() { return wrtr->failed(); }
+  void close();
+
+  void set_run_info(std::shared_ptr<HepMC3::GenRunInfo> run) {
+    HepMC3::Writer::set_run_info(run);
+    wrtr->set_run_info(run);
+  }
+  void set_options(std::map<std::string, std::string> const &options) {
+    wrtr->set_options(options);
+  }
+  std::map<std::string, std::string> get_options() const {
+    return wrtr->get_options();
+  }
+
+  // nullptr until the first event has been written
+  std::shared_ptr<FATX::Accumulator const> accumulator() const { return acc; }
+};
+
 } // namespace Writer
 } // namespace NuHepMC
\ No newline at end of file
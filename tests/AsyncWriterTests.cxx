@@ -0,0 +1,100 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/AsyncWriter.hxx"
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+
+namespace {
+
+// fails every write after the first nok events
+class FailingWriter : public HepMC3::Writer {
+  int nok;
+  int nwritten;
+
+public:
+  explicit FailingWriter(int n) : nok(n), nwritten(0) {}
+  void write_event(HepMC3::GenEvent const &) { nwritten++; }
+  bool failed() { return nwritten > nok; }
+  void close() {}
+};
+
+int CountEvents(std::string const &fname) {
+  NuHepMC::Reader rdr(fname);
+  HepMC3::GenEvent evt;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nread);
+    nread++;
+  }
+  return nread;
+}
+
+} // namespace
+
+TEST_CASE("AsyncWriter writes every event in order", "[AsyncWriter]") {
+  auto inname = WriteTestFile("AsyncWriterTests_in.hepmc3", 50);
+  std::string outname = "AsyncWriterTests_out.hepmc3";
+
+  NuHepMC::Reader rdr(inname);
+  NuHepMC::Writer::WriterOptions opts;
+  opts.async = true;
+  opts.async_depth = 4;
+  std::unique_ptr<HepMC3::Writer> wrtr(
+      NuHepMC::Writer::make_writer(outname, rdr.run_info(), opts));
+  auto async = dynamic_cast<NuHepMC::AsyncWriter *>(wrtr.get());
+  REQUIRE(async);
+
+  auto evt = std::make_unique<HepMC3::GenEvent>();
+  int nwritten = 0;
+  while (true) {
+    rdr.read_event(*evt);
+    if (rdr.failed()) {
+      break;
+    }
+    auto before = evt.get();
+    // alternate between the swapping and copying interfaces
+    if (nwritten % 2) {
+      async->write_event(evt);
+      REQUIRE(evt.get() != before);
+      REQUIRE(evt->particles().empty());
+    } else {
+      async->write_event(*evt);
+    }
+    nwritten++;
+  }
+  async->close();
+  REQUIRE(!async->failed());
+
+  REQUIRE(CountEvents(outname) == 50);
+
+  std::remove(inname.c_str());
+  std::remove(outname.c_str());
+}
+
+TEST_CASE("AsyncWriter reports write errors at close", "[AsyncWriter]") {
+  NuHepMC::AsyncWriter wrtr(std::make_shared<FailingWriter>(5), 2);
+
+  HepMC3::GenEvent evt;
+  for (int i = 0; i < 20; ++i) {
+    evt.set_event_number(i);
+    wrtr.write_event(evt);
+  }
+
+  REQUIRE_THROWS_AS(wrtr.close(), NuHepMC::AsyncWriter::WriteFailed);
+  REQUIRE(wrtr.failed());
+  // the error is only thrown once
+  REQUIRE_NOTHROW(wrtr.close());
+
+  REQUIRE_THROWS_AS(NuHepMC::AsyncWriter(nullptr),
+                    NuHepMC::AsyncWriter::NullWriter);
+  REQUIRE_THROWS_AS(NuHepMC::AsyncWriter(std::make_shared<FailingWriter>(0), 0),
+                    NuHepMC::AsyncWriter::InvalidQueueDepth);
+}
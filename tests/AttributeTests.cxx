@@ -130,3 +130,37 @@ TEST_CASE("HasAttributeOfType", "[AttributeUtils]") {
   REQUIRE(!NuHepMC::HasAttributeOfType<int>(gri, "d"));
   REQUIRE(!NuHepMC::HasAttributeOfType<std::vector<std::string>>(gri, "d"));
 }
+
+TEST_CASE("AttributeKey", "[AttributeUtils]") {
+  HepMC3::GenEvent evt;
+  NuHepMC::add_attribute(evt, "a", 1);
+  NuHepMC::add_attribute(evt, "b", std::vector<double>{1, 2, 3});
+
+  NuHepMC::AttributeKey<int> const a("a");
+  NuHepMC::AttributeKey<std::vector<double>> const b("b");
+  NuHepMC::AttributeKey<double> const c("c");
+
+  REQUIRE(a.name() == "a");
+  REQUIRE(a.has(&evt));
+  REQUIRE(a.value(&evt) == 1);
+  REQUIRE(a.value(&evt, 2) == 1);
+  REQUIRE(b.value(&evt) == std::vector<double>{1, 2, 3});
+  REQUIRE(!c.has(&evt));
+  REQUIRE(c.value(&evt, 4.5) == 4.5);
+  REQUIRE_THROWS_AS(c.value(&evt), NuHepMC::MissingAttributeException);
+
+  NuHepMC::AttributeKey<std::vector<std::string>> const a_as_strs("a");
+  REQUIRE(!a_as_strs.has(&evt));
+  REQUIRE_THROWS_AS(a_as_strs.value(&evt), NuHepMC::AttributeTypeException);
+  REQUIRE_THROWS_AS(a_as_strs.value(&evt, {}),
+                    NuHepMC::AttributeTypeException);
+
+  HepMC3::GenEvent const *nullevt = nullptr;
+  REQUIRE_THROWS_AS(a.has(nullevt), NuHepMC::NullObjectException);
+
+  // the free functions route through the same lookup
+  REQUIRE(NuHepMC::CheckedAttributeValue<int>(&evt, "a") == 1);
+  REQUIRE(NuHepMC::CheckedAttributeValue<double>(&evt, "c", 4.5) == 4.5);
+  REQUIRE(NuHepMC::HasAttributeOfType<std::vector<double>>(&evt, "b"));
+  REQUIRE(!NuHepMC::HasAttributeOfType<int>(&evt, "b"));
+}
@@ -0,0 +1,78 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/ChainReader.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+
+TEST_CASE("ChainReader reads every file in order", "[ChainReader]") {
+  std::vector<std::string> fnames = {
+      WriteTestFile("ChainReaderTests_0.hepmc3", 10),
+      WriteTestFile("ChainReaderTests_1.hepmc3", 0),
+      WriteTestFile("ChainReaderTests_2.hepmc3", 25)};
+
+  NuHepMC::ChainReader rdr(fnames);
+  REQUIRE(rdr.nfiles() == 3);
+  REQUIRE(bool(rdr.run_info()));
+  REQUIRE(rdr.file_index() == 0);
+
+  HepMC3::GenEvent evt;
+  std::vector<int> nread(3, 0);
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nread[rdr.file_index()]);
+    REQUIRE(evt.run_info() == rdr.file_run_info(rdr.file_index()));
+    nread[rdr.file_index()]++;
+  }
+  REQUIRE(nread == std::vector<int>{10, 0, 25});
+  REQUIRE(rdr.failed());
+  REQUIRE(rdr.file_index() == 2);
+  for (size_t i = 0; i < rdr.nfiles(); ++i) {
+    REQUIRE(bool(rdr.file_run_info(i)));
+  }
+
+  NuHepMC::ChainReader globbed("ChainReaderTests_*.hepmc3");
+  REQUIRE(globbed.nfiles() == 3);
+  REQUIRE(globbed.skip(12));
+  REQUIRE(globbed.read_event(evt));
+  REQUIRE(globbed.file_index() == 2);
+  REQUIRE(evt.event_number() == 2);
+
+  for (auto const &fname : fnames) {
+    std::remove(fname.c_str());
+  }
+}
+
+TEST_CASE("ChainReader rejects incompatible files", "[ChainReader]") {
+  std::vector<std::string> fnames = {
+      WriteTestFile("ChainReaderTests_cv.hepmc3", 5),
+      "ChainReaderTests_universes.hepmc3"};
+
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR7::SetWeightNames(gri, {"CV", "universe_1"});
+  {
+    HepMC3::WriterAscii wrtr(fnames[1], gri);
+    HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+    evt.weights() = {1, 1};
+    wrtr.write_event(evt);
+    wrtr.close();
+  }
+
+  NuHepMC::ChainReader rdr(fnames);
+  HepMC3::GenEvent evt;
+  REQUIRE(rdr.skip(5));
+  REQUIRE_THROWS_AS(rdr.read_event(evt),
+                    NuHepMC::ChainReader::IncompatibleRunInfo);
+
+  REQUIRE_THROWS_AS(NuHepMC::ChainReader(std::vector<std::string>{}),
+                    NuHepMC::ChainReader::EmptyChain);
+
+  for (auto const &fname : fnames) {
+    std::remove(fname.c_str());
+  }
+}
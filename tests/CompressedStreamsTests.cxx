@@ -0,0 +1,281 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/CompressedStreams.hxx"
+#include "NuHepMC/EventIndex.hxx"
+#include "NuHepMC/HepMC3Features.hxx"
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "HepMC3/ReaderFactory.h"
+
+#include "TestFiles.hxx"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string ReadAll(std::istream &is) {
+  return std::string(std::istreambuf_iterator<char>(is),
+                     std::istreambuf_iterator<char>());
+}
+
+// the events of a file numbered from 0, as written by WriteTestFile
+int CountEvents(HepMC3::Reader &rdr) {
+  HepMC3::GenEvent evt;
+  int nevents = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nevents);
+    nevents++;
+  }
+  return nevents;
+}
+
+void CopyEvents(std::string const &inname, std::string const &outname,
+                NuHepMC::Writer::WriterOptions const &opts) {
+  NuHepMC::Reader rdr(inname);
+  std::unique_ptr<HepMC3::Writer> wrtr(
+      NuHepMC::Writer::make_writer(outname, rdr.run_info(), opts));
+  HepMC3::GenEvent evt;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    wrtr->write_event(evt);
+  }
+  REQUIRE(!wrtr->failed());
+  wrtr->close();
+}
+
+} // namespace
+
+TEST_CASE("Parallel compression round trips", "[Compression]") {
+  std::string contents;
+  for (int i = 0; i < 20000; ++i) {
+    contents += "line " + std::to_string(i % 97) + " of some event text\n";
+  }
+
+  // only the formats that the library was built with
+  std::vector<NuHepMC::Compression::Format> fmts = {
+#if HEPMC3_Z_SUPPORT == 1
+      NuHepMC::Compression::Format::kZ,
+#endif
+#if HEPMC3_LZMA_SUPPORT == 1
+      NuHepMC::Compression::Format::kLZMA,
+#endif
+#if HEPMC3_BZ2_SUPPORT == 1
+      NuHepMC::Compression::Format::kBZip2,
+#endif
+#if HEPMC3_ZSTD_SUPPORT == 1
+      NuHepMC::Compression::Format::kZstd,
+#endif
+  };
+  for (auto fmt : fmts) {
+    std::string fname = "CompressedStreamsTests.out";
+    {
+      auto os = NuHepMC::Compression::OpenCompressed(fname, fmt, 3, 1 << 14);
+      // uneven writes that straddle block boundaries
+      for (size_t pos = 0; pos < contents.size(); pos += 1001) {
+        size_t n = std::min<size_t>(1001, contents.size() - pos);
+        os->write(contents.data() + pos, std::streamsize(n));
+        os->flush();
+      }
+      os->finish();
+      REQUIRE(!os->fail());
+    }
+
+    REQUIRE(NuHepMC::Compression::DetectFormat(fname) == fmt);
+    auto is = NuHepMC::Compression::OpenDecompressed(fname);
+    REQUIRE(ReadAll(*is) == contents);
+
+    // an empty stream is still a valid compressed file
+    { NuHepMC::Compression::OpenCompressed(fname, fmt, 2)->finish(); }
+    REQUIRE(NuHepMC::Compression::DetectFormat(fname) == fmt);
+    is = NuHepMC::Compression::OpenDecompressed(fname);
+    REQUIRE(ReadAll(*is).empty());
+
+    std::remove(fname.c_str());
+  }
+}
+
+#if HEPMC3_Z_SUPPORT == 1
+TEST_CASE("make_writer compresses in independent blocks", "[Compression]") {
+  auto inname = WriteTestFile("CompressedStreamsTests_in.hepmc3", 200);
+  std::string gzname = "CompressedStreamsTests_out.hepmc3.gz";
+
+  NuHepMC::Writer::WriterOptions opts;
+  opts.compression_threads = 4;
+  opts.compression_block_size = 4096;
+  CopyEvents(inname, gzname, opts);
+
+  std::ifstream plain(inname, std::ios::binary);
+  auto is = NuHepMC::Compression::OpenDecompressed(gzname);
+  REQUIRE(ReadAll(*is) == ReadAll(plain));
+
+  // every block is a checkpoint for the event index
+  auto idx = NuHepMC::BuildEventIndex(gzname);
+  REQUIRE(idx.size() == 200);
+  REQUIRE(idx.checkpoints.size() > 2);
+
+  std::remove(inname.c_str());
+  std::remove(gzname.c_str());
+}
+#endif
+
+TEST_CASE("Block compressed outputs can be read by HepMC3 readers",
+          "[Compression]") {
+  auto inname = WriteTestFile("CompressedStreamsTests_hin.hepmc3", 150);
+
+  std::vector<std::string> exts = {
+#if HEPMC3_Z_SUPPORT == 1
+      "gz",
+#endif
+#if HEPMC3_LZMA_SUPPORT == 1
+      "lzma",
+#endif
+#if HEPMC3_BZ2_SUPPORT == 1
+      "bz2",
+#endif
+  };
+  for (auto const &ext : exts) {
+    std::string fname = "CompressedStreamsTests_stock.hepmc3." + ext;
+    NuHepMC::Writer::WriterOptions opts;
+    opts.compression_threads = 3;
+    // many more blocks, and so compressed members, than threads
+    opts.compression_block_size = 2048;
+    CopyEvents(inname, fname, opts);
+
+    auto rdr = HepMC3::deduce_reader(fname);
+    REQUIRE(rdr);
+    REQUIRE(CountEvents(*rdr) == 150);
+    rdr->close();
+
+    NuHepMC::Reader nrdr(fname);
+    REQUIRE(CountEvents(nrdr) == 150);
+
+    std::remove(fname.c_str());
+  }
+
+  std::remove(inname.c_str());
+}
+
+#if HEPMC3_ZSTD_SUPPORT == 1
+TEST_CASE("zstd outputs can be read back by Reader", "[Compression]") {
+  auto inname = WriteTestFile("CompressedStreamsTests_zin.hepmc3", 100);
+  std::string zstname = "CompressedStreamsTests_out.hepmc3.zst";
+
+  NuHepMC::Writer::WriterOptions opts;
+  opts.compression_threads = 2;
+  opts.compression_block_size = 4096;
+  opts.compression_level = 19;
+  {
+    NuHepMC::Reader rdr(inname);
+    std::unique_ptr<HepMC3::Writer> wrtr(
+        NuHepMC::Writer::make_writer(zstname, rdr.run_info(), opts));
+    HepMC3::GenEvent evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      wrtr->write_event(evt);
+    }
+    wrtr->close();
+  }
+
+  REQUIRE(NuHepMC::Compression::DetectFormat(zstname) ==
+          NuHepMC::Compression::Format::kZstd);
+
+  NuHepMC::Reader rdr(zstname);
+  REQUIRE(rdr.run_info());
+  HepMC3::GenEvent evt;
+  int nevents = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nevents);
+    nevents++;
+  }
+  REQUIRE(nevents == 100);
+
+  REQUIRE(rdr.read_range(40, 50));
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.event_number() == 40);
+
+  std::remove(inname.c_str());
+  std::remove(zstname.c_str());
+}
+#endif
+
+#if HEPMC3_Z_SUPPORT == 1
+TEST_CASE("Seekable outputs are indexed on close", "[Compression]") {
+  auto inname = WriteTestFile("CompressedStreamsTests_sin.hepmc3", 200);
+  std::string gzname = "CompressedStreamsTests_seekable.hepmc3.gz";
+
+  NuHepMC::Writer::WriterOptions opts;
+  opts.compression_threads = 3;
+  opts.compression_block_size = 4096;
+  opts.seekable = true;
+  {
+    NuHepMC::Reader rdr(inname);
+    std::unique_ptr<HepMC3::Writer> wrtr(
+        NuHepMC::Writer::make_writer(gzname, rdr.run_info(), opts));
+    HepMC3::GenEvent evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      wrtr->write_event(evt);
+    }
+    wrtr->close();
+  }
+
+  auto written =
+      NuHepMC::ReadEventIndex(NuHepMC::EventIndexFilename(gzname));
+  auto scanned = NuHepMC::BuildEventIndex(gzname);
+  REQUIRE(written.size() == 200);
+  REQUIRE(written.event_offsets == scanned.event_offsets);
+  REQUIRE(written.header_size == scanned.header_size);
+  REQUIRE(written.end_offset == scanned.end_offset);
+  REQUIRE(written.file_size == scanned.file_size);
+  REQUIRE(written.checkpoints == scanned.checkpoints);
+  REQUIRE(written.checkpoints.size() > 2);
+
+  // every block after the first starts at an event record
+  for (size_t i = 1; i < written.checkpoints.size(); ++i) {
+    REQUIRE(std::binary_search(written.event_offsets.begin(),
+                               written.event_offsets.end(),
+                               written.checkpoints[i].second));
+  }
+
+  NuHepMC::Reader rdr(gzname);
+  REQUIRE(rdr.read_range(150, 160));
+  HepMC3::GenEvent evt;
+  int nevents = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == 150 + nevents);
+    nevents++;
+  }
+  REQUIRE(nevents == 10);
+
+  std::remove(inname.c_str());
+  std::remove(gzname.c_str());
+  std::remove(NuHepMC::EventIndexFilename(gzname).c_str());
+}
+#endif
@@ -0,0 +1,80 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventHeader.hxx"
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/ReaderUtils.hxx"
+#include "NuHepMC/WriterUtils.hxx"
+
+#include "TestFiles.hxx"
+
+TEST_CASE("EventHeaderDecoder agrees with ReaderUtils", "[EventHeader]") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR7::SetWeightNames(gri, {"other", "CV"});
+
+  HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+  evt.set_event_number(7);
+  evt.weights() = {0.5, 2};
+  NuHepMC::ER3::SetProcessID(evt, 200);
+  NuHepMC::ER5::SetLabPosition(evt, {1, 2, 3, 4});
+  NuHepMC::EC2::SetTotalCrossSection(evt, 10);
+  NuHepMC::EC3::SetProcessCrossSection(evt, 5);
+  auto xs = std::make_shared<HepMC3::GenCrossSection>();
+  xs->set_cross_section({1, 3}, {0, 0});
+  evt.set_cross_section(xs);
+
+  NuHepMC::EventHeaderDecoder decoder;
+  auto header = decoder.decode(evt);
+
+  REQUIRE(decoder.cv_weight_index() == 1);
+  REQUIRE(header.event_number == 7);
+  REQUIRE(header.has(NuHepMC::EventHeader::kProcessID));
+  REQUIRE(header.process_id == NuHepMC::ER3::ReadProcessID(evt));
+  REQUIRE(header.has(NuHepMC::EventHeader::kLabPosition));
+  REQUIRE(header.lab_position == std::array<double, 4>{1, 2, 3, 4});
+  REQUIRE(header.total_xsec == NuHepMC::EC2::ReadTotalCrossSection(evt));
+  REQUIRE(header.process_xsec == NuHepMC::EC3::ReadProcessCrossSection(evt));
+  REQUIRE(header.fatx_best_estimate ==
+          NuHepMC::EC4::ReadFluxAveragedTotalXSecCVBestEstimate(evt));
+  REQUIRE(header.cv_weight == 2);
+
+  // an event without any metadata
+  HepMC3::GenEvent bare(HepMC3::Units::MEV, HepMC3::Units::MM);
+  decoder.decode(bare, header);
+  REQUIRE(decoder.cv_weight_index() == -1);
+  REQUIRE(header.present == 0);
+  REQUIRE(header.process_id == 0);
+  REQUIRE(header.total_xsec == 0);
+  REQUIRE(!header.has(NuHepMC::EventHeader::kCVWeight));
+}
+
+TEST_CASE("EventHeaderColumns fills in batches", "[EventHeader]") {
+  auto fname = WriteTestFile("EventHeaderTests_columns.hepmc3", 25);
+  NuHepMC::Reader rdr(fname);
+
+  NuHepMC::EventHeaderDecoder decoder;
+  NuHepMC::EventHeaderColumns columns(10);
+  HepMC3::GenEvent evt;
+
+  std::vector<size_t> batches;
+  std::vector<int> event_numbers;
+  while (true) {
+    columns.clear();
+    size_t n = columns.fill(rdr, decoder, evt);
+    if (!n) {
+      break;
+    }
+    batches.push_back(n);
+    REQUIRE(columns.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+      event_numbers.push_back(columns.event_number[i]);
+      REQUIRE(columns.cv_weight[i] == 1);
+      REQUIRE(columns.present[i] & NuHepMC::EventHeader::kCVWeight);
+    }
+  }
+
+  REQUIRE(batches == std::vector<size_t>{10, 10, 5});
+  REQUIRE(event_numbers.size() == 25);
+  for (int i = 0; i < 25; ++i) {
+    REQUIRE(event_numbers[i] == i);
+  }
+}
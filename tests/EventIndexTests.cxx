@@ -0,0 +1,124 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventIndex.hxx"
+#include "NuHepMC/Reader.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#if HEPMC3_Z_SUPPORT == 1
+#include <zlib.h>
+#endif
+
+TEST_CASE("EventIndex records every event", "[EventIndex]") {
+  auto fname = WriteTestFile("EventIndexTests_build.hepmc3", 20);
+
+  auto idx = NuHepMC::BuildEventIndex(fname);
+  REQUIRE(idx.size() == 20);
+  REQUIRE(idx.compression == NuHepMC::Compression::Format::kNone);
+  REQUIRE(idx.header_size == idx.event_offsets.front());
+  REQUIRE(idx.end_offset > idx.event_offsets.back());
+
+  std::ifstream ifs(fname);
+  for (auto o : idx.event_offsets) {
+    ifs.seekg(std::streamoff(o));
+    REQUIRE(ifs.get() == 'E');
+  }
+
+  NuHepMC::WriteEventIndex(idx, NuHepMC::EventIndexFilename(fname));
+  auto ridx = NuHepMC::ReadEventIndex(NuHepMC::EventIndexFilename(fname));
+  REQUIRE(ridx.event_offsets == idx.event_offsets);
+  REQUIRE(ridx.header_size == idx.header_size);
+  REQUIRE(ridx.end_offset == idx.end_offset);
+  REQUIRE(ridx.file_size == idx.file_size);
+
+  std::remove(NuHepMC::EventIndexFilename(fname).c_str());
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Reader::seek and Reader::read_range", "[EventIndex]") {
+  auto fname = WriteTestFile("EventIndexTests_seek.hepmc3", 20);
+
+  NuHepMC::Reader rdr(fname);
+  HepMC3::GenEvent evt;
+
+  REQUIRE(rdr.seek(13));
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.event_number() == 13);
+  REQUIRE(evt.run_info() == rdr.run_info());
+  REQUIRE(evt.particles().size() == 3);
+
+  // the sidecar was written and is reused
+  std::ifstream sidecar(NuHepMC::EventIndexFilename(fname));
+  REQUIRE(sidecar.good());
+
+  REQUIRE(rdr.seek(2));
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.event_number() == 2);
+
+  REQUIRE(rdr.read_range(5, 8));
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == (5 + nread));
+    nread++;
+  }
+  REQUIRE(nread == 3);
+
+  REQUIRE(!rdr.seek(20));
+  REQUIRE(!rdr.read_event(evt));
+
+  NuHepMC::Reader rdr2(fname);
+  REQUIRE(rdr2.event_index().size() == 20);
+
+  std::remove(NuHepMC::EventIndexFilename(fname).c_str());
+  std::remove(fname.c_str());
+}
+
+#if HEPMC3_Z_SUPPORT == 1
+TEST_CASE("EventIndex checkpoints multi-member gzip files", "[EventIndex]") {
+  auto fname = WriteTestFile("EventIndexTests_gz.hepmc3", 20);
+  std::string gzname = fname + ".gz";
+
+  std::stringstream ss;
+  ss << std::ifstream(fname).rdbuf();
+  std::string contents = ss.str();
+
+  // write the file as two independently compressed gzip members
+  size_t split = contents.size() / 2;
+  gzFile gz = gzopen(gzname.c_str(), "wb");
+  gzwrite(gz, contents.data(), unsigned(split));
+  gzclose(gz);
+  gz = gzopen(gzname.c_str(), "ab");
+  gzwrite(gz, contents.data() + split, unsigned(contents.size() - split));
+  gzclose(gz);
+
+  auto idx = NuHepMC::BuildEventIndex(gzname);
+  REQUIRE(idx.compression == NuHepMC::Compression::Format::kZ);
+  REQUIRE(idx.checkpoints.size() == 2);
+  REQUIRE(idx.checkpoints[1].second == split);
+  REQUIRE(idx.event_offsets == NuHepMC::BuildEventIndex(fname).event_offsets);
+
+  auto rdr = NuHepMC::OpenEventRangeReader(gzname, idx, 15, 18);
+  HepMC3::GenEvent evt;
+  int nread = 0;
+  while (true) {
+    rdr->read_event(evt);
+    if (rdr->failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == (15 + nread));
+    nread++;
+  }
+  REQUIRE(nread == 3);
+
+  std::remove(gzname.c_str());
+  std::remove(fname.c_str());
+}
+#endif
@@ -0,0 +1,111 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventLoop.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+
+struct LoopState {
+  size_t nevents = 0;
+  double sum_pz = 0;
+  std::vector<int> event_numbers;
+};
+
+LoopState RunLoop(std::string const &fname, size_t nthreads,
+                  std::shared_ptr<NuHepMC::FATX::Accumulator> acc) {
+  NuHepMC::EventLoopOptions opts;
+  opts.nthreads = nthreads;
+  opts.chunk_size = 7;
+
+  NuHepMC::EventLoop loop(std::make_shared<NuHepMC::Reader>(fname), opts);
+  return loop.run(
+      LoopState{},
+      [](HepMC3::GenEvent const &evt, double w, LoopState &state) {
+        state.nevents++;
+        for (auto const &part : evt.particles()) {
+          state.sum_pz += w * part->momentum().pz() / 3.0;
+        }
+        state.event_numbers.push_back(evt.event_number());
+      },
+      [](LoopState &into, LoopState const &chunk) {
+        into.nevents += chunk.nevents;
+        into.sum_pz += chunk.sum_pz;
+        into.event_numbers.insert(into.event_numbers.end(),
+                                  chunk.event_numbers.begin(),
+                                  chunk.event_numbers.end());
+      },
+      acc);
+}
+
+TEST_CASE("EventLoop results do not depend on thread count", "[EventLoop]") {
+  auto fname = WriteTestFile("EventLoopTests.hepmc3", 500);
+
+  auto acc1 = NuHepMC::FATX::MakeAccumulator("Dummy");
+  auto res1 = RunLoop(fname, 1, acc1);
+  REQUIRE(res1.nevents == 500);
+  REQUIRE(acc1->events() == 500);
+  REQUIRE(acc1->TargetAverageA() == 12);
+
+  for (int i = 0; i < 500; ++i) {
+    REQUIRE(res1.event_numbers[i] == i);
+  }
+
+  for (size_t nthreads : {2, 3, 8}) {
+    auto acc = NuHepMC::FATX::MakeAccumulator("Dummy");
+    auto res = RunLoop(fname, nthreads, acc);
+    REQUIRE(res.nevents == res1.nevents);
+    REQUIRE(res.sum_pz == res1.sum_pz);
+    REQUIRE(res.event_numbers == res1.event_numbers);
+    REQUIRE(acc->events() == acc1->events());
+  }
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("EventLoop E.C.2 FATX does not depend on thread count",
+          "[EventLoop]") {
+  auto fname = WriteTestFile("EventLoopTests_EC2.hepmc3", 500, "E.C.2");
+
+  NuHepMC::Reader rdr(fname);
+  auto serial = NuHepMC::FATX::MakeAccumulator(rdr.run_info());
+  HepMC3::GenEvent evt;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    serial->process(evt);
+  }
+  REQUIRE(serial->events() == 500);
+
+  for (size_t nthreads : {1, 2, 3, 8}) {
+    auto acc = NuHepMC::FATX::MakeAccumulator(rdr.run_info());
+    RunLoop(fname, nthreads, acc);
+    REQUIRE(acc->events() == serial->events());
+    REQUIRE(acc->fatx() == serial->fatx());
+  }
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("EventLoop rethrows worker exceptions", "[EventLoop]") {
+  auto fname = WriteTestFile("EventLoopTests_throw.hepmc3", 100);
+
+  NuHepMC::EventLoopOptions opts;
+  opts.nthreads = 4;
+  opts.chunk_size = 5;
+
+  NuHepMC::EventLoop loop(std::make_shared<NuHepMC::Reader>(fname), opts);
+  REQUIRE_THROWS_AS(loop.run(
+                        0,
+                        [](HepMC3::GenEvent const &evt, double, int &) {
+                          if (evt.event_number() == 42) {
+                            throw std::runtime_error("bad event");
+                          }
+                        },
+                        [](int &, int const &) {}),
+                    std::runtime_error);
+
+  std::remove(fname.c_str());
+}
@@ -0,0 +1,170 @@
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventPool.hxx"
+#include "NuHepMC/PrefetchReader.hxx"
+
+#include "TestFiles.hxx"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// count every allocation made by the test executable, including those made
+// inside HepMC3
+namespace {
+std::atomic<size_t> nallocs(0);
+}
+
+void *operator new(std::size_t n) {
+  nallocs++;
+  if (void *p = std::malloc(n ? n : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+TEST_CASE("EventPool recycles released events", "[EventPool]") {
+  NuHepMC::EventPool pool(1);
+
+  auto a = pool.acquire();
+  auto b = pool.acquire();
+  REQUIRE(pool.created() == 2);
+
+  auto a_ptr = a.get();
+  pool.release(std::move(a));
+  pool.release(std::move(b));
+  pool.release(nullptr);
+  // only one event is kept
+  REQUIRE(pool.size() == 1);
+
+  REQUIRE(pool.acquire().get() == a_ptr);
+  REQUIRE(pool.reused() == 1);
+  REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Reader reads into pooled events", "[EventPool]") {
+  auto fname = WriteTestFile("EventPoolTests.hepmc3", 100);
+
+  NuHepMC::Reader rdr(fname);
+  auto pool = rdr.event_pool();
+
+  std::unique_ptr<HepMC3::GenEvent> evt;
+  std::vector<std::unique_ptr<HepMC3::GenEvent>> kept;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt->event_number() == nread);
+    REQUIRE(evt->particles().size() == 3);
+    REQUIRE(bool(evt->run_info()));
+    if (nread++ < 10) {
+      kept.push_back(std::move(evt));
+    }
+  }
+  REQUIRE(nread == 100);
+  // the peeked first event, and one per event kept back
+  REQUIRE(pool->created() == 11);
+
+  for (auto &k : kept) {
+    pool->release(std::move(k));
+  }
+  REQUIRE(pool->size() == 10);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("PrefetchReader recycles through the reader's pool",
+          "[EventPool]") {
+  auto fname = WriteTestFile("EventPoolTests_prefetch.hepmc3", 200);
+
+  size_t const depth = 4;
+  NuHepMC::PrefetchReader rdr(fname, depth);
+
+  std::unique_ptr<HepMC3::GenEvent> evt;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt->event_number() == nread);
+    nread++;
+  }
+  REQUIRE(nread == 200);
+  // the ring, the consumer's event, and the one being decoded
+  REQUIRE(rdr.event_pool()->created() <= depth + 2);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Allocations per event with and without pooling",
+          "[EventPool]") {
+  auto fname = WriteTestFile("EventPoolTests_allocs.hepmc3", 500);
+
+  size_t fresh = 0;
+  {
+    NuHepMC::Reader rdr(fname);
+    size_t before = nallocs;
+    while (true) {
+      HepMC3::GenEvent evt;
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+    }
+    fresh = nallocs - before;
+  }
+
+  size_t pooled = 0;
+  {
+    NuHepMC::Reader rdr(fname);
+    size_t before = nallocs;
+    std::unique_ptr<HepMC3::GenEvent> evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+    }
+    pooled = nallocs - before;
+  }
+
+  CAPTURE(fresh, pooled);
+  REQUIRE(pooled < fresh);
+
+  BENCHMARK("read into a new GenEvent per event") {
+    NuHepMC::Reader rdr(fname);
+    size_t n = 0;
+    while (true) {
+      HepMC3::GenEvent evt;
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      n++;
+    }
+    return n;
+  };
+
+  BENCHMARK("read into pooled GenEvents") {
+    NuHepMC::Reader rdr(fname);
+    size_t n = 0;
+    std::unique_ptr<HepMC3::GenEvent> evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      n++;
+    }
+    return n;
+  };
+
+  std::remove(fname.c_str());
+}
@@ -0,0 +1,157 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventStore.hxx"
+#include "NuHepMC/FlatEvent.hxx"
+#include "NuHepMC/Reader.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+HepMC3::GenEvent MakeStoredEvent(std::shared_ptr<HepMC3::GenRunInfo> gri,
+                                 int ievt) {
+  auto evt = MakeBusyEvent();
+  evt.set_run_info(gri);
+  evt.set_event_number(ievt);
+  evt.weights() = {0.5 * ievt, 2};
+  NuHepMC::ER3::SetProcessID(evt, 200 + ievt);
+  NuHepMC::ER5::SetLabPosition(evt, {1, 2, 3, 4});
+  NuHepMC::EC2::SetTotalCrossSection(evt, 10);
+  auto xs = std::make_shared<HepMC3::GenCrossSection>();
+  xs->set_cross_section({3, 3}, {0, 0});
+  evt.set_cross_section(xs);
+  return evt;
+}
+
+void RequireSameEvent(NuHepMC::EventStore const &store, size_t i,
+                      HepMC3::GenEvent const &evt) {
+  NuHepMC::FlatEvent fe(evt);
+  auto view = store.event(i);
+  REQUIRE(view.nparticles == fe.size());
+  REQUIRE(view.nvertices == fe.vtx_status.size());
+  for (size_t k = 0; k < fe.size(); ++k) {
+    REQUIRE(view.pid[k] == fe.pid[k]);
+    REQUIRE(view.status[k] == fe.status[k]);
+    REQUIRE(view.prod_vtx[k] == fe.prod_vtx[k]);
+    REQUIRE(view.end_vtx[k] == fe.end_vtx[k]);
+    if (store.has_momenta()) {
+      REQUIRE(view.momenta[k][2] == float(fe.pz[k]));
+      REQUIRE(view.momenta[k][3] == float(fe.e[k]));
+    }
+  }
+  for (size_t j = 0; j < fe.vtx_status.size(); ++j) {
+    REQUIRE(view.vtx_status[j] == fe.vtx_status[j]);
+  }
+  REQUIRE(std::vector<double>(view.weights, view.weights + view.nweights) ==
+          evt.weights());
+
+  NuHepMC::EventHeaderDecoder decoder;
+  auto hdr = decoder.decode(evt);
+  auto stored = store.header(i);
+  REQUIRE(stored.present == hdr.present);
+  REQUIRE(stored.event_number == hdr.event_number);
+  REQUIRE(stored.process_id == hdr.process_id);
+  REQUIRE(stored.lab_position == hdr.lab_position);
+  REQUIRE(stored.total_xsec == hdr.total_xsec);
+  REQUIRE(stored.fatx_best_estimate == hdr.fatx_best_estimate);
+  REQUIRE(stored.cv_weight == hdr.cv_weight);
+}
+} // namespace
+
+TEST_CASE("EventStore keeps and rebuilds events", "[EventStore]") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR7::SetWeightNames(gri, {"CV", "other"});
+
+  NuHepMC::EventStore store;
+  std::vector<HepMC3::GenEvent> evts;
+  for (int i = 0; i < 5; ++i) {
+    evts.push_back(MakeStoredEvent(gri, i));
+    REQUIRE(store.add(evts.back()) == size_t(i));
+  }
+  REQUIRE(store.size() == 5);
+  REQUIRE(store.nparticles() == 5 * evts[0].particles().size());
+
+  HepMC3::GenEvent rebuilt(gri);
+  for (size_t i = 0; i < store.size(); ++i) {
+    RequireSameEvent(store, i, evts[i]);
+
+    store.rebuild(i, rebuilt);
+    REQUIRE(rebuilt.run_info() == gri);
+    REQUIRE(rebuilt.momentum_unit() == HepMC3::Units::MEV);
+    RequireSameEvent(store, i, rebuilt);
+  }
+
+  // momenta are converted to the unit of the store, and can be left out
+  NuHepMC::EventStore gev(true, HepMC3::Units::GEV);
+  gev.add(evts[0]);
+  REQUIRE(gev.event(0).momentum(0).e() ==
+          float(evts[0].particles()[0]->momentum().e() * 1E-3));
+
+  NuHepMC::EventStore slim(false);
+  slim.add(evts[0]);
+  REQUIRE(!slim.event(0).momenta);
+  REQUIRE(slim.bytes() < gev.bytes());
+}
+
+TEST_CASE("EventStore round trips through a mapped file", "[EventStore]") {
+  auto fname = WriteTestFile("EventStoreTests.hepmc3", 100);
+  std::string const store_name = "EventStoreTests.evs";
+
+  NuHepMC::EventStore store;
+  std::vector<HepMC3::GenEvent> evts;
+  {
+    NuHepMC::Reader rdr(fname);
+    HepMC3::GenEvent evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      // keep every other event
+      if (evt.event_number() % 2) {
+        continue;
+      }
+      store.add(evt);
+      evts.push_back(evt);
+    }
+  }
+  REQUIRE(store.size() == 50);
+  store.save(store_name);
+
+  auto loaded = NuHepMC::EventStore::load(store_name);
+  REQUIRE(loaded.size() == store.size());
+  REQUIRE(loaded.bytes() == store.bytes());
+  REQUIRE(loaded.has_momenta());
+  for (size_t i = 0; i < loaded.size(); ++i) {
+    RequireSameEvent(loaded, i, evts[i]);
+  }
+
+  // adding to a loaded store copies it out of the file first
+  loaded.add(evts[0]);
+  REQUIRE(loaded.size() == 51);
+  RequireSameEvent(loaded, 0, evts[0]);
+  RequireSameEvent(loaded, 50, evts[0]);
+
+  {
+    std::ofstream ofs(store_name, std::ios::binary | std::ios::trunc);
+    ofs << "not an event store, but long enough to have a header......";
+  }
+  REQUIRE_THROWS_AS(NuHepMC::EventStore::load(store_name),
+                    NuHepMC::EventStore::InvalidStoreFile);
+
+  store.save(store_name);
+  {
+    std::ifstream ifs(store_name, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+    std::ofstream ofs(store_name, std::ios::binary | std::ios::trunc);
+    ofs.write(contents.data(), std::streamsize(contents.size() / 2));
+  }
+  REQUIRE_THROWS_AS(NuHepMC::EventStore::load(store_name),
+                    NuHepMC::EventStore::InvalidStoreFile);
+
+  std::remove(fname.c_str());
+  std::remove(store_name.c_str());
+}
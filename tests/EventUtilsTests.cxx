@@ -0,0 +1,162 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/EventUtils.hxx"
+
+#include "TestFiles.hxx"
+
+#include "HepMC3/GenParticle.h"
+
+TEST_CASE("Event::Index agrees with scanning queries", "[EventUtils]") {
+  auto evt = MakeBusyEvent();
+  NuHepMC::Event::Index idx(evt);
+
+  REQUIRE(NuHepMC::Event::GetPrimaryVertex(idx) ==
+          NuHepMC::Event::GetPrimaryVertex(evt));
+  REQUIRE(NuHepMC::Event::GetVertex_First(
+              idx, NuHepMC::VertexStatus::FSISummary) ==
+          NuHepMC::Event::GetVertex_First(
+              evt, NuHepMC::VertexStatus::FSISummary));
+  REQUIRE(NuHepMC::Event::GetVertex_First(idx, 0) ==
+          NuHepMC::Event::GetVertex_First(evt, 0));
+  REQUIRE(!NuHepMC::Event::GetVertex_First(idx, 12345));
+  REQUIRE(NuHepMC::Event::GetBeamParticle(idx) ==
+          NuHepMC::Event::GetBeamParticle(evt));
+  REQUIRE(NuHepMC::Event::GetTargetParticle(idx) ==
+          NuHepMC::Event::GetTargetParticle(evt));
+  REQUIRE(NuHepMC::Event::GetTargetPDG(idx) == 1000060120);
+
+  std::vector<std::vector<int>> const pdg_sets = {
+      {}, {2212}, {211, 13}, {13, 211}, {2212, 2212}, {22}, {9999}};
+  for (int status : {0, NuHepMC::ParticleStatus::UndecayedPhysical,
+                     NuHepMC::ParticleStatus::DecayedPhysical, 12345}) {
+    for (auto const &pdgs : pdg_sets) {
+      REQUIRE(NuHepMC::Event::GetParticles_All(idx, status, pdgs) ==
+              NuHepMC::Event::GetParticles_All(evt, status, pdgs));
+      REQUIRE(NuHepMC::Event::GetParticle_First(idx, status, pdgs) ==
+              NuHepMC::Event::GetParticle_First(evt, status, pdgs));
+      auto hm = NuHepMC::Event::GetParticle_HighestMomentum(idx, status, pdgs);
+      auto hm_evt =
+          NuHepMC::Event::GetParticle_HighestMomentum(evt, status, pdgs);
+      REQUIRE(bool(hm) == bool(hm_evt));
+      if (hm) {
+        REQUIRE(hm->momentum().p3mod2() == hm_evt->momentum().p3mod2());
+      }
+    }
+  }
+
+  auto protons =
+      NuHepMC::Event::GetParticles_AllRealFinalState(idx, {2212});
+  REQUIRE(protons.size() == 3);
+  REQUIRE(NuHepMC::Event::GetParticle_HighestMomentumRealFinalState(idx, {2212})
+              ->momentum()
+              .pz() == 450);
+  // equal |p| resolves to the first in event order
+  REQUIRE(NuHepMC::Event::GetParticle_HighestMomentumRealFinalState(
+              idx, {2212, 2112}) == protons[1]);
+}
+
+TEST_CASE("Event::Index can be rebuilt for new events", "[EventUtils]") {
+  auto evt = MakeBusyEvent();
+  NuHepMC::Event::Index idx(evt);
+
+  HepMC3::GenEvent empty;
+  idx.build(empty);
+  REQUIRE(!NuHepMC::Event::GetPrimaryVertex(idx));
+  REQUIRE(!NuHepMC::Event::GetBeamParticle(idx));
+  REQUIRE(NuHepMC::Event::GetParticles_All(idx, 0).empty());
+  REQUIRE(!NuHepMC::Event::GetParticle_HighestMomentum(idx, 0));
+
+  idx.build(evt);
+  REQUIRE(idx.with_status(NuHepMC::ParticleStatus::UndecayedPhysical).size() ==
+          10);
+  REQUIRE(idx.with_pid(2212).size() == 4);
+  REQUIRE(idx.with_status_and_pid(NuHepMC::ParticleStatus::UndecayedPhysical,
+                                  2212)
+              .size() == 3);
+}
+
+TEST_CASE("PDGSet", "[EventUtils]") {
+  constexpr NuHepMC::PDGSet charged_pions{211, -211};
+  static_assert(charged_pions.contains(-211), "");
+  static_assert(!charged_pions.contains(111), "");
+  static_assert(NuHepMC::PDGSet{}.contains(111), "");
+
+  REQUIRE(NuHepMC::PDGSet(std::vector<int>{13, 11}).contains(11));
+  REQUIRE_THROWS_AS(NuHepMC::PDGSet(std::vector<int>(17, 11)),
+                    NuHepMC::TooManyPDGCodes);
+}
+
+TEST_CASE("Allocation-free selections agree with the vector API",
+          "[EventUtils]") {
+  auto evt = MakeBusyEvent();
+
+  std::vector<std::vector<int>> const pdg_sets = {
+      {}, {2212}, {211, 13}, {13, 211}, {2212, 2212}, {22}, {9999}};
+  std::vector<HepMC3::GenParticle const *> selected;
+  for (int status : {0, NuHepMC::ParticleStatus::UndecayedPhysical,
+                     NuHepMC::ParticleStatus::DecayedPhysical, 12345}) {
+    for (auto const &pdgs : pdg_sets) {
+      NuHepMC::PDGSet set(pdgs);
+
+      auto parts = NuHepMC::Event::GetParticles_All(evt, status, pdgs);
+      REQUIRE(NuHepMC::Event::SelectParticles(evt, status, set, selected) ==
+              parts.size());
+      for (size_t i = 0; i < parts.size(); ++i) {
+        REQUIRE(selected[i] == parts[i].get());
+      }
+
+      size_t nvisited = 0;
+      NuHepMC::Event::VisitParticles(
+          evt, status, set, [&](HepMC3::ConstGenParticlePtr const &part) {
+            REQUIRE(part == parts[nvisited++]);
+          });
+      REQUIRE(nvisited == parts.size());
+
+      REQUIRE(NuHepMC::Event::FindParticle_First(evt, status, set) ==
+              NuHepMC::Event::GetParticle_First(evt, status, pdgs).get());
+
+      auto hm = NuHepMC::Event::FindParticle_HighestMomentum(evt, status, set);
+      REQUIRE(hm ==
+              NuHepMC::Event::GetParticle_HighestMomentum(evt, status, pdgs)
+                  .get());
+      if (hm) {
+        for (auto const &part : parts) {
+          REQUIRE(part->momentum().p3mod2() <= hm->momentum().p3mod2());
+        }
+      }
+
+      auto he = NuHepMC::Event::FindParticle_HighestEnergy(evt, status, set);
+      REQUIRE(bool(he) == bool(parts.size()));
+      if (he) {
+        for (auto const &part : parts) {
+          REQUIRE(part->momentum().e() <= he->momentum().e());
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Highest momentum ties go to the first particle", "[EventUtils]") {
+  auto evt = MakeBusyEvent();
+
+  // the proton and neutron at 450 MeV/c tie
+  auto hm = NuHepMC::Event::FindParticle_HighestMomentum(
+      evt, NuHepMC::ParticleStatus::UndecayedPhysical, {2212, 2112});
+  REQUIRE(hm->pid() == 2212);
+  REQUIRE(hm->momentum().pz() == 450);
+
+  HepMC3::ConstGenVertexPtr vtx = NuHepMC::Event::GetPrimaryVertex(evt);
+  REQUIRE(NuHepMC::Vertex::GetParticleOut_HighestMomentum(
+              vtx, NuHepMC::ParticleStatus::UndecayedPhysical, {2112, 2212})
+              .get() == hm);
+  REQUIRE(NuHepMC::Vertex::FindParticleOut_HighestMomentum(vtx, 0) ==
+          evt.particles()[2].get());
+  REQUIRE(NuHepMC::Vertex::FindParticleIn_HighestMomentum(
+              vtx, 0, {1000060120})
+              ->pid() == 1000060120);
+
+  size_t nin = 0;
+  NuHepMC::Vertex::VisitParticlesIn(
+      vtx, 0, {}, [&](HepMC3::ConstGenParticlePtr const &) { nin++; });
+  REQUIRE(nin == 2);
+}
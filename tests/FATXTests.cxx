@@ -0,0 +1,337 @@
+#include "catch2/catch_approx.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/ReaderUtils.hxx"
+#include "NuHepMC/WriterUtils.hxx"
+
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+
+#include <cmath>
+#include <sstream>
+
+std::shared_ptr<HepMC3::GenRunInfo> MakeRunInfo(std::string const &conv) {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR4::SetConventions(gri, {conv});
+  NuHepMC::GR6::SetCrossSectionUnits(gri, "pb", "PerAtom");
+  NuHepMC::GR7::SetWeightNames(gri, {"CV"});
+  NuHepMC::GC2::SetFluxAveragedTotalXSec(gri, 1.23E-2);
+  return gri;
+}
+
+// alternates between carbon and hydrogen targets with weights and total cross
+// sections spanning a few orders of magnitude
+std::vector<HepMC3::GenEvent>
+MakeEvents(std::shared_ptr<HepMC3::GenRunInfo> gri, int nevents) {
+  std::vector<HepMC3::GenEvent> events;
+  for (int i = 0; i < nevents; ++i) {
+    HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+    evt.set_event_number(i);
+    evt.weights() = {1.0 + (i % 17) * 1E-3 + (i % 3) * 1E3};
+    NuHepMC::EC2::SetTotalCrossSection(evt, 1E-3 * (1 + (i % 11)));
+
+    auto vtx = std::make_shared<HepMC3::GenVertex>();
+    vtx->set_status(NuHepMC::VertexStatus::Primary);
+    vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, 1000, 1000), 14,
+        NuHepMC::ParticleStatus::IncomingBeam));
+    vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, 0, 1000), (i % 2) ? 1000060120 : 2212,
+        NuHepMC::ParticleStatus::Target));
+    evt.add_vertex(vtx);
+    events.push_back(evt);
+  }
+  return events;
+}
+
+TEST_CASE("Merged FATX accumulators match a single pass", "[FATX]") {
+  for (std::string conv : {"G.C.2", "E.C.2"}) {
+    auto gri = MakeRunInfo(conv);
+    auto events = MakeEvents(gri, 1000);
+
+    auto whole = NuHepMC::FATX::MakeAccumulator(gri);
+    for (auto const &evt : events) {
+      whole->process(evt);
+    }
+
+    auto merged = whole->clone();
+    for (int part = 0; part < 4; ++part) {
+      auto partial = whole->clone();
+      for (int i = part * 250; i < (part + 1) * 250; ++i) {
+        partial->process(events[i]);
+      }
+      merged->merge(*partial);
+    }
+
+    REQUIRE(merged->events() == whole->events());
+    REQUIRE(merged->sumweights() ==
+            Catch::Approx(whole->sumweights()).epsilon(1E-15));
+    REQUIRE(merged->fatx() == Catch::Approx(whole->fatx()).epsilon(1E-15));
+    auto per_nucleon = NuHepMC::CrossSection::Units::cm2ten38_PerNucleon;
+    REQUIRE(merged->fatx(per_nucleon) ==
+            Catch::Approx(whole->fatx(per_nucleon)).epsilon(1E-15));
+    REQUIRE(merged->TargetAverageA() ==
+            Catch::Approx(whole->TargetAverageA()).epsilon(1E-15));
+  }
+}
+
+TEST_CASE("FATX accumulators round trip through serialise", "[FATX]") {
+  for (std::string conv : {"G.C.2", "E.C.2", "Dummy"}) {
+    auto gri = MakeRunInfo(conv);
+    auto events = MakeEvents(gri, 100);
+
+    auto acc = (conv == "Dummy") ? NuHepMC::FATX::MakeAccumulator(conv)
+                                 : NuHepMC::FATX::MakeAccumulator(gri);
+    for (auto const &evt : events) {
+      acc->process(evt);
+    }
+
+    std::stringstream ss;
+    acc->serialise(ss);
+    auto read = NuHepMC::FATX::Deserialise(ss);
+
+    REQUIRE(read->to_string() == acc->to_string());
+    REQUIRE(read->events() == acc->events());
+    REQUIRE(read->sumweights() == acc->sumweights());
+    REQUIRE(read->fatx() == acc->fatx());
+    REQUIRE(read->TargetAverageZ() == acc->TargetAverageZ());
+
+    // deserialised state keeps accumulating
+    read->merge(*acc);
+    REQUIRE(read->events() == 2 * acc->events());
+  }
+}
+
+TEST_CASE("FATX accumulator merge and deserialise errors", "[FATX]") {
+  auto gc2 = NuHepMC::FATX::MakeAccumulator("G.C.2");
+  auto ec2 = NuHepMC::FATX::MakeAccumulator("E.C.2");
+  auto dummy = NuHepMC::FATX::MakeAccumulator("Dummy");
+
+  REQUIRE_THROWS_AS(gc2->merge(*ec2),
+                    NuHepMC::FATX::IncompatibleAccumulators);
+  REQUIRE_THROWS_AS(dummy->merge(*gc2),
+                    NuHepMC::FATX::IncompatibleAccumulators);
+
+  // G.C.2 accumulators from runs with different FATX
+  auto gri_a = MakeRunInfo("G.C.2");
+  auto gri_b = MakeRunInfo("G.C.2");
+  NuHepMC::GC2::SetFluxAveragedTotalXSec(gri_b, 2E-2);
+  auto gc2_a = NuHepMC::FATX::MakeAccumulator(gri_a);
+  auto gc2_b = NuHepMC::FATX::MakeAccumulator(gri_b);
+  gc2_a->process(MakeEvents(gri_a, 1).front());
+  gc2_b->process(MakeEvents(gri_b, 1).front());
+  REQUIRE_THROWS_AS(gc2_a->merge(*gc2_b),
+                    NuHepMC::FATX::IncompatibleAccumulators);
+
+  std::stringstream ss("not an accumulator");
+  REQUIRE_THROWS_AS(NuHepMC::FATX::Deserialise(ss),
+                    NuHepMC::FATX::InvalidSerialisedAccumulator);
+
+  std::stringstream truncated;
+  ec2->serialise(truncated);
+  auto str = truncated.str();
+  std::stringstream ts(str.substr(0, str.size() - 5));
+  REQUIRE_THROWS_AS(NuHepMC::FATX::Deserialise(ts),
+                    NuHepMC::FATX::InvalidSerialisedAccumulator);
+}
+
+TEST_CASE("MultiWeightAccumulator", "[FATX]") {
+  for (std::string conv : {"G.C.2", "E.C.2"}) {
+    auto gri = MakeRunInfo(conv);
+    NuHepMC::GR7::SetWeightNames(gri, {"CV", "up", "carbon_only"});
+    auto events = MakeEvents(gri, 1000);
+
+    double sumw_cv = 0, sumw_c = 0, recip_cv = 0, recip_c = 0;
+    for (auto &evt : events) {
+      double w = evt.weights()[0];
+      bool carbon = (evt.event_number() % 2);
+      evt.weights() = {w, 2 * w, carbon ? w : 0};
+      double xs = NuHepMC::EC2::ReadTotalCrossSection(evt);
+      sumw_cv += w;
+      sumw_c += carbon ? w : 0;
+      recip_cv += w / xs;
+      recip_c += carbon ? (w / xs) : 0;
+    }
+
+    auto acc = NuHepMC::FATX::MakeMultiWeightAccumulator(gri);
+    auto cv = NuHepMC::FATX::MakeAccumulator(gri);
+    for (auto const &evt : events) {
+      REQUIRE(acc->process(evt) == cv->process(evt));
+    }
+
+    REQUIRE(acc->size() == 3);
+    REQUIRE(acc->fatx() == cv->fatx());
+    REQUIRE(acc->sumweights() == cv->sumweights());
+    REQUIRE(acc->sumweights("CV") == Catch::Approx(sumw_cv));
+    REQUIRE(acc->sumweights("up") == Catch::Approx(2 * sumw_cv));
+    REQUIRE(acc->sumweights(2) == Catch::Approx(sumw_c));
+    REQUIRE(acc->fatx("CV") == Catch::Approx(cv->fatx()));
+
+    double carbon_ratio = (conv == "G.C.2")
+                              ? (sumw_c / sumw_cv)
+                              : ((sumw_c / recip_c) / (sumw_cv / recip_cv));
+    double up_ratio = (conv == "G.C.2") ? 2 : 1;
+    auto fatxs = acc->all_fatx();
+    REQUIRE(fatxs.size() == 3);
+    REQUIRE(fatxs[1] == Catch::Approx(up_ratio * cv->fatx()));
+    REQUIRE(fatxs[2] == Catch::Approx(carbon_ratio * cv->fatx()));
+    REQUIRE(acc->fatx("carbon_only") == fatxs[2]);
+
+    REQUIRE_THROWS_AS(acc->fatx("missing"), NuHepMC::FATX::UnknownWeightName);
+
+    auto merged = acc->clone();
+    auto half = acc->clone();
+    for (size_t i = 0; i < events.size(); ++i) {
+      ((i < 500) ? merged : half)->process(events[i]);
+    }
+    merged->merge(*half);
+    auto const &mw =
+        dynamic_cast<NuHepMC::FATX::MultiWeightAccumulator const &>(*merged);
+    REQUIRE(mw.events() == acc->events());
+    REQUIRE(mw.fatx(2) == Catch::Approx(fatxs[2]).epsilon(1E-15));
+
+    std::stringstream ss;
+    acc->serialise(ss);
+    using NuHepMC::FATX::MultiWeightAccumulator;
+    auto read = std::dynamic_pointer_cast<MultiWeightAccumulator>(
+        NuHepMC::FATX::Deserialise(ss));
+    REQUIRE(read);
+    REQUIRE(read->weight_names() == acc->weight_names());
+    REQUIRE(read->all_sumweights() == acc->all_sumweights());
+    REQUIRE(read->all_fatx() == fatxs);
+    REQUIRE(read->to_string() == acc->to_string());
+
+    HepMC3::GenEvent short_evt = events.front();
+    short_evt.weights() = {1};
+    REQUIRE_THROWS_AS(acc->process(short_evt),
+                      NuHepMC::FATX::WeightVectorSizeMismatch);
+  }
+}
+
+TEST_CASE("MultiWeightAccumulator rejects inconsistent serialised states",
+          "[FATX]") {
+  using NuHepMC::FATX::MultiWeightAccumulator;
+  auto serialised = [](MultiWeightAccumulator::Method method, int cv_index) {
+    MultiWeightAccumulator acc(NuHepMC::FATX::MakeAccumulator("E.C.2"),
+                               method, {"CV", "up"}, cv_index);
+    std::stringstream ss;
+    acc.serialise(ss);
+    return ss.str();
+  };
+
+  // states that differ in a single field, whose bytes are swapped in below
+  auto sumw_state = serialised(MultiWeightAccumulator::Method::kSumWeights, 0);
+  auto xsec_state = serialised(MultiWeightAccumulator::Method::kEventXSec, 0);
+  auto cv1_state = serialised(MultiWeightAccumulator::Method::kSumWeights, 1);
+  REQUIRE(sumw_state.size() == xsec_state.size());
+  REQUIRE(sumw_state.size() == cv1_state.size());
+
+  // sets the first byte where other differs from sumw_state to value
+  auto tampered = [&](std::string const &other, char value) {
+    size_t pos = 0;
+    while (sumw_state[pos] == other[pos]) {
+      pos++;
+    }
+    auto bad = sumw_state;
+    bad[pos] = value;
+    return bad;
+  };
+
+  // kReciprocalXSec without its per-universe reciprocal sums
+  std::stringstream no_recip(tampered(xsec_state, 1));
+  REQUIRE_THROWS_AS(NuHepMC::FATX::Deserialise(no_recip),
+                    NuHepMC::FATX::InvalidSerialisedAccumulator);
+  // a CV weight index past the last weight
+  std::stringstream bad_cv(tampered(cv1_state, 2));
+  REQUIRE_THROWS_AS(NuHepMC::FATX::Deserialise(bad_cv),
+                    NuHepMC::FATX::InvalidSerialisedAccumulator);
+
+  // the untouched state still reads
+  std::stringstream good(sumw_state);
+  REQUIRE(NuHepMC::FATX::Deserialise(good));
+}
+
+TEST_CASE("E.C.4 accumulators require an event cross section", "[FATX]") {
+  auto gri = MakeRunInfo("E.C.4");
+  auto evt = MakeEvents(gri, 1).front();
+  REQUIRE(!evt.cross_section());
+
+  auto acc = NuHepMC::FATX::MakeAccumulator(gri);
+  auto mw_acc = NuHepMC::FATX::MakeMultiWeightAccumulator(gri);
+  REQUIRE_THROWS_AS(acc->process(evt), NuHepMC::FATX::MissingEventCrossSection);
+  REQUIRE_THROWS_AS(mw_acc->process(evt),
+                    NuHepMC::FATX::MissingEventCrossSection);
+}
+
+TEST_CASE("FATX accumulator uncertainties", "[FATX]") {
+  auto gri = MakeRunInfo("E.C.2");
+  auto events = MakeEvents(gri, 1000);
+
+  double sw = 0, sw2 = 0, sr = 0;
+  double c_sw = 0, c_sw2 = 0;
+  for (auto const &evt : events) {
+    double w = evt.weights()[0];
+    sw += w;
+    sw2 += w * w;
+    sr += w / NuHepMC::EC2::ReadTotalCrossSection(evt);
+    if (evt.event_number() % 2) {
+      c_sw += w;
+      c_sw2 += w * w;
+    }
+  }
+  double R = sw / sr;
+  double var = 0;
+  for (auto const &evt : events) {
+    double w = evt.weights()[0];
+    double r = w / NuHepMC::EC2::ReadTotalCrossSection(evt);
+    var += (w - R * r) * (w - R * r);
+  }
+  var /= (sr * sr);
+
+  auto acc = NuHepMC::FATX::MakeAccumulator(gri);
+  REQUIRE(!acc->is_converged(1));
+  acc->process(events[0]);
+  REQUIRE(!acc->is_converged(1));
+  for (size_t i = 1; i < events.size(); ++i) {
+    acc->process(events[i]);
+  }
+
+  REQUIRE(acc->sumweights2() == Catch::Approx(sw2));
+  REQUIRE(acc->effective_sample_size() == Catch::Approx(sw * sw / sw2));
+  REQUIRE(acc->effective_sample_size(1000060120) ==
+          Catch::Approx(c_sw * c_sw / c_sw2));
+  REQUIRE(acc->effective_sample_size(1000080160) == 0);
+  REQUIRE(acc->fatx_relative_error() == Catch::Approx(std::sqrt(var) / R));
+  REQUIRE(acc->fatx_relative_error(1000010010) > 0);
+  REQUIRE(acc->is_converged(2 * acc->fatx_relative_error()));
+  REQUIRE(!acc->is_converged(0.5 * acc->fatx_relative_error()));
+
+  std::stringstream ss;
+  acc->serialise(ss);
+  auto read = NuHepMC::FATX::Deserialise(ss);
+  REQUIRE(read->fatx_relative_error() == acc->fatx_relative_error());
+  REQUIRE(read->fatx_relative_error(1000010010) ==
+          acc->fatx_relative_error(1000010010));
+  REQUIRE(read->effective_sample_size(1000010010) ==
+          acc->effective_sample_size(1000010010));
+
+  auto merged = acc->clone();
+  auto half = acc->clone();
+  for (size_t i = 0; i < events.size(); ++i) {
+    ((i < 500) ? merged : half)->process(events[i]);
+  }
+  merged->merge(*half);
+  REQUIRE(merged->fatx_relative_error() ==
+          Catch::Approx(acc->fatx_relative_error()).epsilon(1E-12));
+
+  // G.C.2 reads the FATX so it has no statistical error of its own
+  auto gc2 = NuHepMC::FATX::MakeAccumulator(MakeRunInfo("G.C.2"));
+  for (auto const &evt : MakeEvents(MakeRunInfo("G.C.2"), 10)) {
+    gc2->process(evt);
+  }
+  REQUIRE(gc2->fatx_relative_error() == 0);
+  REQUIRE(gc2->is_converged(0));
+  REQUIRE(gc2->effective_sample_size() > 0);
+}
@@ -0,0 +1,120 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/FDStreams.hxx"
+#include "NuHepMC/HepMC3Features.hxx"
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "TestFiles.hxx"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+void WriteEvents(HepMC3::Writer &wrtr,
+                 std::shared_ptr<HepMC3::GenRunInfo> gri, int nevents) {
+  for (int i = 0; i < nevents; ++i) {
+    HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+    evt.set_event_number(i);
+    evt.weights() = {1};
+    wrtr.write_event(evt);
+  }
+  wrtr.close();
+}
+
+std::shared_ptr<HepMC3::GenRunInfo> TestRunInfo() {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR7::SetWeightNames(gri, {"CV"});
+  return gri;
+}
+
+int CountEvents(NuHepMC::Reader &rdr) {
+  HepMC3::GenEvent evt;
+  int nevents = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nevents);
+    nevents++;
+  }
+  return nevents;
+}
+} // namespace
+
+TEST_CASE("Streams round trip with compression detected from magic bytes",
+          "[FDStreams]") {
+  auto gri = TestRunInfo();
+
+  // only the formats that the library was built with
+  std::vector<NuHepMC::Compression::Format> fmts = {
+      NuHepMC::Compression::Format::kNone,
+#if HEPMC3_Z_SUPPORT == 1
+      NuHepMC::Compression::Format::kZ,
+#endif
+#if HEPMC3_BZ2_SUPPORT == 1
+      NuHepMC::Compression::Format::kBZip2,
+#endif
+#if HEPMC3_LZMA_SUPPORT == 1
+      NuHepMC::Compression::Format::kLZMA,
+#endif
+#if HEPMC3_ZSTD_SUPPORT == 1
+      NuHepMC::Compression::Format::kZstd,
+#endif
+  };
+  for (auto fmt : fmts) {
+    auto ss = std::make_shared<std::stringstream>();
+    {
+      std::unique_ptr<HepMC3::Writer> wrtr(
+          NuHepMC::Writer::make_writer(ss, gri, fmt));
+      WriteEvents(*wrtr, gri, 25);
+    }
+    auto in = std::make_shared<std::istringstream>(ss->str());
+    NuHepMC::Reader rdr(in);
+    REQUIRE(bool(rdr.run_info()));
+    REQUIRE(CountEvents(rdr) == 25);
+  }
+
+  NuHepMC::Writer::WriterOptions opts;
+  opts.seekable = true;
+  REQUIRE_THROWS_AS(
+      NuHepMC::Writer::make_writer(std::make_shared<std::stringstream>(), gri,
+                                   NuHepMC::Compression::Format::kZ, opts),
+      NuHepMC::UnsupportedWriterOption);
+
+  // only HepMC3 ascii can be written to stdout
+  for (std::string name : {"-.proto", "-.proto.gz", "-.gz.zst"}) {
+    REQUIRE_THROWS(NuHepMC::Writer::make_writer(name, gri));
+  }
+}
+
+TEST_CASE("Events can be piped between threads", "[FDStreams]") {
+  int fds[2];
+  REQUIRE(::pipe(fds) == 0);
+
+  auto gri = TestRunInfo();
+#if HEPMC3_Z_SUPPORT == 1
+  auto const fmt = NuHepMC::Compression::Format::kZ;
+#else
+  auto const fmt = NuHepMC::Compression::Format::kNone;
+#endif
+  std::thread producer([&]() {
+    NuHepMC::Writer::WriterOptions opts;
+    opts.compression_block_size = 1024;
+    std::unique_ptr<HepMC3::Writer> wrtr(NuHepMC::Writer::make_writer(
+        std::make_shared<NuHepMC::FDOStream>(fds[1], true), gri, fmt, opts));
+    WriteEvents(*wrtr, gri, 500);
+  });
+
+  NuHepMC::Reader rdr(std::make_shared<NuHepMC::FDIStream>(fds[0], true));
+  REQUIRE(CountEvents(rdr) == 500);
+  producer.join();
+
+  REQUIRE_THROWS_AS(NuHepMC::FDIStream(-1),
+                    NuHepMC::FDStreamBuf::InvalidFileDescriptor);
+}
@@ -0,0 +1,89 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/FlatEvent.hxx"
+
+#include "TestFiles.hxx"
+
+TEST_CASE("FlatEvent mirrors the event", "[FlatEvent]") {
+  auto evt = MakeBusyEvent();
+  NuHepMC::FlatEvent fe(evt);
+
+  auto const &parts = evt.particles();
+  REQUIRE(fe.size() == parts.size());
+  REQUIRE(fe.vtx_status.size() == evt.vertices().size());
+
+  for (size_t i = 0; i < fe.size(); ++i) {
+    REQUIRE(fe.pid[i] == parts[i]->pid());
+    REQUIRE(fe.status[i] == parts[i]->status());
+    REQUIRE(fe.px[i] == parts[i]->momentum().px());
+    REQUIRE(fe.pz[i] == parts[i]->momentum().pz());
+    REQUIRE(fe.e[i] == parts[i]->momentum().e());
+    REQUIRE(fe.mass[i] == parts[i]->generated_mass());
+
+    auto prod = parts[i]->production_vertex();
+    if (prod) {
+      REQUIRE(evt.vertices()[fe.prod_vtx[i]] == prod);
+    } else {
+      REQUIRE(fe.prod_vtx[i] == -1);
+    }
+    auto end = parts[i]->end_vertex();
+    if (end) {
+      REQUIRE(evt.vertices()[fe.end_vtx[i]] == end);
+    } else {
+      REQUIRE(fe.end_vtx[i] == -1);
+    }
+  }
+  REQUIRE(fe.vtx_status[0] == NuHepMC::VertexStatus::Primary);
+
+  // refilling with a smaller event shrinks every array
+  HepMC3::GenEvent empty(HepMC3::Units::GEV, HepMC3::Units::MM);
+  fe.fill(empty);
+  REQUIRE(fe.size() == 0);
+  REQUIRE(fe.mass.size() == 0);
+  REQUIRE(fe.vtx_status.size() == 0);
+  REQUIRE(fe.momentum_unit == HepMC3::Units::GEV);
+  REQUIRE(fe.count(0) == 0);
+  REQUIRE(fe.max_momentum(0) == 0);
+  REQUIRE(fe.highest_momentum(0) == -1);
+}
+
+TEST_CASE("FlatEvent kernels agree with EventUtils", "[FlatEvent]") {
+  auto evt = MakeBusyEvent();
+  NuHepMC::FlatEvent fe(evt);
+
+  std::vector<NuHepMC::PDGSet> const pdg_sets = {
+      {}, {2212}, {211, 13}, {22}, {9999}, {1000060120, 14}};
+  std::vector<int> selected;
+  for (int status : {0, NuHepMC::ParticleStatus::UndecayedPhysical,
+                     NuHepMC::ParticleStatus::DecayedPhysical, 12345}) {
+    for (auto const &pdgs : pdg_sets) {
+      std::vector<HepMC3::GenParticle const *> parts;
+      NuHepMC::Event::SelectParticles(evt, status, pdgs, parts);
+
+      REQUIRE(fe.count(status, pdgs) == parts.size());
+      REQUIRE(fe.select(status, pdgs, selected) == parts.size());
+
+      HepMC3::FourVector sum(0, 0, 0, 0);
+      for (size_t i = 0; i < parts.size(); ++i) {
+        REQUIRE(parts[i] == evt.particles()[selected[i]].get());
+        sum = sum + parts[i]->momentum();
+      }
+      auto fsum = fe.sum_momentum(status, pdgs);
+      REQUIRE(fsum.px() == sum.px());
+      REQUIRE(fsum.py() == sum.py());
+      REQUIRE(fsum.pz() == sum.pz());
+      REQUIRE(fsum.e() == sum.e());
+
+      auto hm =
+          NuHepMC::Event::FindParticle_HighestMomentum(evt, status, pdgs);
+      int ihm = fe.highest_momentum(status, pdgs);
+      if (hm) {
+        REQUIRE(evt.particles()[ihm].get() == hm);
+        REQUIRE(fe.max_momentum(status, pdgs) == hm->momentum().p3mod());
+      } else {
+        REQUIRE(ihm == -1);
+        REQUIRE(fe.max_momentum(status, pdgs) == 0);
+      }
+    }
+  }
+}
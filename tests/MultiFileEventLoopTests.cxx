@@ -0,0 +1,153 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/MultiFileEventLoop.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+#include <map>
+
+struct Counts {
+  // the number of times each event number was seen
+  std::map<int, int> event_numbers;
+  std::map<size_t, size_t> events_per_file;
+  double sumw = 0;
+};
+
+TEST_CASE("MultiFileEventLoop reads every event once", "[MultiFileEventLoop]") {
+  std::vector<std::string> fnames = {
+      WriteTestFile("MultiFileEventLoopTests_big.hepmc3", 500),
+      WriteTestFile("MultiFileEventLoopTests_0.hepmc3", 20),
+      WriteTestFile("MultiFileEventLoopTests_1.hepmc3", 20),
+      WriteTestFile("MultiFileEventLoopTests_2.hepmc3", 3)};
+  // only the big file has an index, so only it is split
+  NuHepMC::LoadOrBuildEventIndex(fnames[0]);
+
+  for (size_t nthreads : {1, 3, 8}) {
+    NuHepMC::MultiFileEventLoopOptions opts;
+    opts.nthreads = nthreads;
+    opts.task_size = 50;
+    opts.make_accumulator = [](std::shared_ptr<HepMC3::GenRunInfo>) {
+      return NuHepMC::FATX::MakeAccumulator("Dummy");
+    };
+
+    NuHepMC::MultiFileEventLoop loop(fnames, opts);
+    auto res = loop.run(
+        Counts{},
+        [](HepMC3::GenEvent const &evt, double w, Counts &counts,
+           size_t ifile) {
+          counts.event_numbers[evt.event_number()]++;
+          counts.events_per_file[ifile]++;
+          counts.sumw += w;
+        },
+        [](Counts &into, Counts const &worker) {
+          for (auto const &en : worker.event_numbers) {
+            into.event_numbers[en.first] += en.second;
+          }
+          for (auto const &ef : worker.events_per_file) {
+            into.events_per_file[ef.first] += ef.second;
+          }
+          into.sumw += worker.sumw;
+        });
+
+    // every file numbers its events from 0
+    std::map<int, int> expected;
+    for (int i = 0; i < 500; ++i) {
+      expected[i] = (i < 3) ? 4 : ((i < 20) ? 3 : 1);
+    }
+    REQUIRE(res.event_numbers == expected);
+    REQUIRE(res.events_per_file ==
+            std::map<size_t, size_t>{{0, 500}, {1, 20}, {2, 20}, {3, 3}});
+    REQUIRE(loop.tasks() == 13);
+    REQUIRE(loop.events() == 543);
+    REQUIRE(res.sumw == 543);
+    REQUIRE(loop.accumulator(0)->events() == 500);
+    REQUIRE(loop.accumulator(1)->events() == 20);
+    REQUIRE(loop.accumulator(2)->events() == 20);
+    REQUIRE(loop.accumulator(3)->events() == 3);
+  }
+
+  for (auto const &fname : fnames) {
+    std::remove(fname.c_str());
+    std::remove(NuHepMC::EventIndexFilename(fname).c_str());
+  }
+}
+
+TEST_CASE("MultiFileEventLoop merges accumulators in event order",
+          "[MultiFileEventLoop]") {
+  std::vector<std::string> fnames = {
+      WriteTestFile("MultiFileEventLoopTests_ec4_0.hepmc3", 400, "E.C.4"),
+      WriteTestFile("MultiFileEventLoopTests_ec4_1.hepmc3", 150, "E.C.4")};
+
+  std::vector<double> serial;
+  for (auto const &fname : fnames) {
+    NuHepMC::Reader rdr(fname);
+    auto acc = NuHepMC::FATX::MakeAccumulator(rdr.run_info());
+    HepMC3::GenEvent evt;
+    while (true) {
+      rdr.read_event(evt);
+      if (rdr.failed()) {
+        break;
+      }
+      acc->process(evt);
+    }
+    serial.push_back(acc->fatx());
+  }
+  // the estimate is that of the last event in each file
+  REQUIRE(serial[0] != serial[1]);
+
+  for (size_t nthreads : {1, 4, 7}) {
+    NuHepMC::MultiFileEventLoopOptions opts;
+    opts.nthreads = nthreads;
+    opts.task_size = 30;
+    opts.build_indexes = true;
+
+    NuHepMC::MultiFileEventLoop loop(fnames, opts);
+    loop.run(
+        0, [](HepMC3::GenEvent const &, double, int &, size_t) {},
+        [](int &, int const &) {});
+    REQUIRE(loop.tasks() == 19);
+    for (size_t i = 0; i < fnames.size(); ++i) {
+      REQUIRE(loop.accumulator(i)->fatx() == serial[i]);
+    }
+  }
+
+  for (auto const &fname : fnames) {
+    std::remove(fname.c_str());
+    std::remove(NuHepMC::EventIndexFilename(fname).c_str());
+  }
+}
+
+TEST_CASE("MultiFileEventLoop rethrows worker exceptions",
+          "[MultiFileEventLoop]") {
+  std::vector<std::string> fnames = {
+      WriteTestFile("MultiFileEventLoopTests_throw_0.hepmc3", 100),
+      WriteTestFile("MultiFileEventLoopTests_throw_1.hepmc3", 100)};
+
+  NuHepMC::MultiFileEventLoopOptions opts;
+  opts.nthreads = 4;
+  opts.task_size = 10;
+  opts.build_indexes = true;
+  opts.make_accumulator = nullptr;
+
+  NuHepMC::MultiFileEventLoop loop(fnames, opts);
+  REQUIRE_THROWS_AS(loop.run(
+                        0,
+                        [](HepMC3::GenEvent const &evt, double w, int &,
+                           size_t) {
+                          if (w != 1) {
+                            throw std::logic_error("weighted event");
+                          }
+                          if (evt.event_number() == 42) {
+                            throw std::runtime_error("bad event");
+                          }
+                        },
+                        [](int &, int const &) {}),
+                    std::runtime_error);
+  REQUIRE(loop.tasks() == 20);
+
+  for (auto const &fname : fnames) {
+    std::remove(fname.c_str());
+    std::remove(NuHepMC::EventIndexFilename(fname).c_str());
+  }
+}
@@ -0,0 +1,154 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/Reader.hxx"
+#include "NuHepMC/make_writer.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+
+TEST_CASE("Reader exposes GenRunInfo on construction", "[Reader]") {
+  auto fname = WriteTestFile("NuHepMCReaderTests_peek.hepmc3", 5);
+
+  NuHepMC::Reader rdr(fname);
+  REQUIRE(!rdr.failed());
+  REQUIRE(bool(rdr.run_info()));
+  REQUIRE(rdr.run_info()->weight_index("CV") == 0);
+  REQUIRE(rdr.momentum_unit() == HepMC3::Units::MEV);
+
+  // the peeked event is handed back first
+  HepMC3::GenEvent evt;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt.event_number() == nread);
+    REQUIRE(evt.run_info() == rdr.run_info());
+    nread++;
+  }
+  REQUIRE(nread == 5);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Reader::skip accounts for the peeked event", "[Reader]") {
+  auto fname = WriteTestFile("NuHepMCReaderTests_skip.hepmc3", 5);
+
+  NuHepMC::Reader rdr(fname);
+  REQUIRE(rdr.skip(2));
+
+  HepMC3::GenEvent evt;
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.event_number() == 2);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Reader skips migration for current-spec files", "[Reader]") {
+  auto fname = WriteTestFile("NuHepMCReaderTests_current.hepmc3", 5);
+
+  NuHepMC::Reader rdr(fname);
+  HepMC3::GenEvent evt;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+  }
+  REQUIRE(rdr.input_version() == 10000);
+  REQUIRE(rdr.events_migrated() == 0);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Reader migrates 0.9 event attributes", "[Reader]") {
+  std::string fname = "NuHepMCReaderTests_090.hepmc3";
+  {
+    auto gri = std::make_shared<HepMC3::GenRunInfo>();
+    NuHepMC::add_attribute(gri, "NuHepMC.Version.Major", 0);
+    NuHepMC::add_attribute(gri, "NuHepMC.Version.Minor", 9);
+    NuHepMC::add_attribute(gri, "NuHepMC.Version.Patch", 0);
+
+    HepMC3::WriterAscii wrtr(fname, gri);
+    for (int i = 0; i < 3; ++i) {
+      HepMC3::GenEvent evt(gri);
+      evt.set_event_number(i);
+      NuHepMC::add_attribute(evt, "ProcID", 200 + i);
+      NuHepMC::add_attribute(evt, "TotXS", 1.5);
+      wrtr.write_event(evt);
+    }
+    wrtr.close();
+  }
+
+  NuHepMC::Reader rdr(fname);
+  REQUIRE(rdr.input_version() == 900);
+
+  HepMC3::GenEvent evt;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(NuHepMC::CheckedAttributeValue<int>(&evt, "signal_process_id") ==
+            (200 + nread));
+    REQUIRE(NuHepMC::CheckedAttributeValue<double>(&evt, "tot_xs") == 1.5);
+    REQUIRE(!NuHepMC::HasAttribute(&evt, "ProcID"));
+    nread++;
+  }
+  REQUIRE(rdr.events_migrated() == 3);
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Reader exposes the FATX summary written on close", "[Reader]") {
+  std::string fname = "NuHepMCReaderTests_summary.hepmc3";
+
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR4::SetConventions(gri, {"G.C.2"});
+  NuHepMC::GR6::SetCrossSectionUnits(gri, "pb", "PerAtom");
+  NuHepMC::GR7::SetWeightNames(gri, {"CV"});
+  NuHepMC::GC2::SetFluxAveragedTotalXSec(gri, 4.56);
+
+  NuHepMC::Writer::WriterOptions opts;
+  opts.fatx_summary = true;
+  {
+    std::unique_ptr<HepMC3::Writer> wrtr(
+        NuHepMC::Writer::make_writer(fname, gri, opts));
+    for (int i = 0; i < 10; ++i) {
+      HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+      evt.set_event_number(i);
+      evt.weights() = {0.5 * (1 + (i % 2))};
+      auto vtx = std::make_shared<HepMC3::GenVertex>();
+      vtx->set_status(NuHepMC::VertexStatus::Primary);
+      vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+          HepMC3::FourVector(0, 0, 0, 11178), (i % 2) ? 1000060120 : 2212,
+          NuHepMC::ParticleStatus::Target));
+      evt.add_vertex(vtx);
+      wrtr->write_event(evt);
+    }
+    wrtr->close();
+  }
+
+  {
+    NuHepMC::Reader rdr(fname);
+    auto summary = rdr.fatx_summary();
+    REQUIRE(summary);
+    REQUIRE(summary->events() == 10);
+    REQUIRE(summary->sumweights() == 7.5);
+    REQUIRE(summary->fatx() == 4.56);
+    auto tsumw = summary->targets_sumweights();
+    REQUIRE(tsumw.size() == 2);
+    REQUIRE(tsumw.at(1000060120) == 5);
+  }
+
+  // a file written afterwards without a summary leaves the old one stale
+  WriteTestFile(fname, 3);
+  REQUIRE(!NuHepMC::Reader(fname).fatx_summary());
+
+  std::remove(NuHepMC::FATX::SummaryFilename(fname).c_str());
+  std::remove(fname.c_str());
+}
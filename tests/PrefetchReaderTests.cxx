@@ -0,0 +1,63 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/PrefetchReader.hxx"
+
+#include "TestFiles.hxx"
+
+#include <cstdio>
+
+TEST_CASE("PrefetchReader reads every event in order", "[PrefetchReader]") {
+  auto fname = WriteTestFile("PrefetchReaderTests.hepmc3", 50);
+
+  NuHepMC::PrefetchReader rdr(fname, 4);
+
+  std::unique_ptr<HepMC3::GenEvent> evt;
+  int nread = 0;
+  while (true) {
+    rdr.read_event(evt);
+    if (rdr.failed()) {
+      break;
+    }
+    REQUIRE(evt->event_number() == nread);
+    REQUIRE(evt->particles().size() == 3);
+    nread++;
+  }
+  REQUIRE(nread == 50);
+  REQUIRE(rdr.failed());
+  REQUIRE(bool(rdr.run_info()));
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("PrefetchReader exposes run info before the first read",
+          "[PrefetchReader]") {
+  auto fname = WriteTestFile("PrefetchReaderTests_runinfo.hepmc3", 5);
+
+  NuHepMC::PrefetchReader rdr(fname, 2);
+  auto gri = rdr.run_info();
+  REQUIRE(bool(gri));
+
+  HepMC3::GenEvent evt;
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.run_info() == gri);
+  REQUIRE(rdr.run_info() == gri);
+
+  rdr.close();
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("PrefetchReader HepMC3::Reader interface", "[PrefetchReader]") {
+  auto fname = WriteTestFile("PrefetchReaderTests_copy.hepmc3", 10);
+
+  NuHepMC::PrefetchReader rdr(fname, 2);
+  REQUIRE(rdr.skip(3));
+
+  HepMC3::GenEvent evt;
+  REQUIRE(rdr.read_event(evt));
+  REQUIRE(evt.event_number() == 3);
+
+  rdr.close();
+
+  std::remove(fname.c_str());
+}
@@ -1,3 +1,4 @@
+#include "catch2/benchmark/catch_benchmark.hpp"
 #include "catch2/catch_test_macros.hpp"
 
 #include "NuHepMC/ReaderUtils.hxx"
@@ -19,13 +20,113 @@ TEST_CASE("GR2::ReadVersion", "[ReaderUtils]") {
   REQUIRE(pat == 3);
 }
 
-TEST_CASE("GC2::ReadExposureNEvents", "[ReaderUtils]") {
+TEST_CASE("GC1::ReadExposure", "[ReaderUtils]") {
   auto gri = std::make_shared<HepMC3::GenRunInfo>();
 
-  NuHepMC::add_attribute(gri,"NuHepMC.Exposure.NEvents",100000l);
+  NuHepMC::add_attribute(gri,"NuHepMC.Exposure.POT",1E20);
+  NuHepMC::add_attribute(gri,"NuHepMC.Exposure.Livetime",3600.0);
 
-  REQUIRE(NuHepMC::GC2::ReadExposureNEvents(gri) == 100000l);
+  REQUIRE(NuHepMC::GC1::ReadExposurePOT(gri) == 1E20);
+  REQUIRE(NuHepMC::GC1::ReadExposureLivetime(gri) == 3600.0);
 }
 
 // ReadVersion
-// ReadVersionString
\ No newline at end of file
+// ReadVersionString
+
+TEST_CASE("TokenizeKey", "[ReaderUtils]") {
+  NuHepMC::KeyTokens tokens;
+
+  REQUIRE(NuHepMC::TokenizeKey("NuHepMC.Version.Major", tokens));
+  REQUIRE(tokens.section == "Version");
+  REQUIRE(!tokens.has_id);
+  REQUIRE(tokens.field == "Major");
+
+  REQUIRE(NuHepMC::TokenizeKey("NuHepMC.ProcessIDs", tokens));
+  REQUIRE(tokens.section == "ProcessIDs");
+  REQUIRE(tokens.field.empty());
+
+  REQUIRE(
+      NuHepMC::TokenizeKey("NuHepMC.Beam[-14].Histogram.BinEdges", tokens));
+  REQUIRE(tokens.section == "Beam");
+  REQUIRE(tokens.has_id);
+  REQUIRE(tokens.id == -14);
+  REQUIRE(tokens.field == "Histogram.BinEdges");
+
+  REQUIRE(NuHepMC::TokenizeKey("NuHepMC.ProcessInfo[200].Name", tokens));
+  REQUIRE(tokens.id == 200);
+  REQUIRE(tokens.field == "Name");
+
+  for (auto bad : {"", "NuHepMC", "NuHepMC.", "nuhepmc.Version.Major",
+                   "NuHepMC.[1].Name", "NuHepMC.Beam[].Name",
+                   "NuHepMC.Beam[14.Name", "NuHepMC.Beam[1a].Name",
+                   "NuHepMC.Beam[14]Name", "NuHepMC.Version.",
+                   "NuHepMC.Beam[99999999999999999999].Name"}) {
+    REQUIRE(!NuHepMC::TokenizeKey(bad, tokens));
+  }
+}
+
+TEST_CASE("ClassifyRunInfoKeys", "[ReaderUtils]") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::add_attribute(gri, "NuHepMC.Citations.Generator.arXiv",
+                         std::string("1234.5678"));
+  NuHepMC::add_attribute(gri, "NuHepMC.Citations.Process[200].DOI",
+                         std::string("10.1000/1"));
+  NuHepMC::add_attribute(gri, "NuHepMC.Citations.Generator.a b", 1);
+  NuHepMC::add_attribute(gri, "NuHepMC.Citations.Generator", 1);
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam[14].MonoEnergetic.Energy", 1.0);
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam[-14].MonoEnergetic.Energy", 1.0);
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam[12].Histogram.BinEdges",
+                         std::vector<double>{0, 1});
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam[12].Histogram.BinContent",
+                         std::vector<double>{1});
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam.Type", std::string("Histogram"));
+  NuHepMC::add_attribute(gri, "Other.Beam[16].MonoEnergetic.Energy", 1.0);
+
+  auto keys = NuHepMC::ClassifyRunInfoKeys(gri);
+  REQUIRE(keys.citations.size() == 2);
+  REQUIRE(keys.citations[0].component == "Generator");
+  REQUIRE(keys.citations[0].type == "arXiv");
+  REQUIRE(keys.citations[1].component == "Process[200]");
+  REQUIRE(keys.citations[1].type == "DOI");
+  REQUIRE(keys.monoenergetic_beams == std::vector<int>{-14, 14});
+  REQUIRE(keys.histogram_beams == std::vector<int>{12});
+
+  auto citations = NuHepMC::GC3::ReadAllCitations(gri);
+  REQUIRE(citations["Process[200]"]["DOI"] == "10.1000/1");
+
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam[0].Histogram.BinEdges",
+                         std::vector<double>{0, 1});
+  REQUIRE_THROWS_AS(NuHepMC::ClassifyRunInfoKeys(gri),
+                    NuHepMC::GC4::InvalidBeamParticleNumber);
+}
+
+TEST_CASE("Run info key scanning benchmark", "[.][benchmark][ReaderUtils]") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  for (int i = 0; i < 4000; ++i) {
+    NuHepMC::add_attribute(gri,
+                           "NuHepMC.ProcessInfo[" + std::to_string(i) +
+                               "].Name",
+                           std::string("proc"));
+    NuHepMC::add_attribute(gri,
+                           "NuHepMC.Citations.Process[" + std::to_string(i) +
+                               "].arXiv",
+                           std::string("1234.5678"));
+  }
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam.EnergyUnit", std::string("GEV"));
+  NuHepMC::add_attribute(gri, "NuHepMC.Beam.Type", std::string("Histogram"));
+  for (int i = 0; i < 2000; ++i) {
+    NuHepMC::add_attribute(
+        gri, "NuHepMC.Beam[" + std::to_string(i + 1) + "].Histogram.BinEdges",
+        std::vector<double>{0, 1});
+  }
+
+  BENCHMARK("ClassifyRunInfoKeys") {
+    return NuHepMC::ClassifyRunInfoKeys(gri);
+  };
+  BENCHMARK("GC3::ReadAllCitations") {
+    return NuHepMC::GC3::ReadAllCitations(gri);
+  };
+  BENCHMARK("GC4::HasEnergyDistribution") {
+    return NuHepMC::GC4::HasEnergyDistribution(gri);
+  };
+}
@@ -0,0 +1,96 @@
+#include "catch2/catch_test_macros.hpp"
+
+#include "NuHepMC/FATXUtils.hxx"
+#include "NuHepMC/ReaderUtils.hxx"
+#include "NuHepMC/RunInfoView.hxx"
+#include "NuHepMC/WriterUtils.hxx"
+
+TEST_CASE("ConventionBit", "[RunInfoView]") {
+  static_assert(NuHepMC::ConventionBit("G.C.1") == 0, "");
+  static_assert(NuHepMC::ConventionBit("E.C.2") == 33, "");
+  static_assert(NuHepMC::ConventionBit("P.C.32") == 127, "");
+
+  REQUIRE(NuHepMC::ConventionBit("G.C.0") == -1);
+  REQUIRE(NuHepMC::ConventionBit("G.C.33") == -1);
+  REQUIRE(NuHepMC::ConventionBit("G.C.") == -1);
+  REQUIRE(NuHepMC::ConventionBit("G.C.2a") == -1);
+  REQUIRE(NuHepMC::ConventionBit("X.C.2") == -1);
+  REQUIRE(NuHepMC::ConventionBit("G.R.2") == -1);
+  REQUIRE(NuHepMC::ConventionBit("") == -1);
+}
+
+TEST_CASE("IdTable", "[RunInfoView]") {
+  NuHepMC::StatusCodeDescriptors compact = {
+      {1, {"a", "A"}}, {2, {"b", "B"}}, {11, {"c", "C"}}};
+  NuHepMC::StatusCodeDescriptors sparse = {
+      {-7, {"a", "A"}}, {2, {"b", "B"}}, {2000000001, {"c", "C"}}};
+
+  for (auto const &descs : {compact, sparse}) {
+    NuHepMC::IdTable table(descs);
+    REQUIRE(table.size() == 3);
+    REQUIRE(table.descriptors() == descs);
+    for (auto const &d : descs) {
+      REQUIRE(table.has(d.first));
+      REQUIRE(table.name(d.first) == d.second.first);
+      REQUIRE(table.description(d.first) == d.second.second);
+    }
+    for (int id : {-8, 0, 3, 12, 2000000000}) {
+      REQUIRE(!table.has(id));
+      REQUIRE(table.name(id) == "");
+    }
+  }
+}
+
+TEST_CASE("RunInfoView agrees with ReaderUtils", "[RunInfoView]") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR4::SetConventions(gri, {"G.C.1", "E.C.2", "my.convention"});
+  NuHepMC::GR6::SetCrossSectionUnits(gri, "1e-38 cm2", "PerNucleon");
+  NuHepMC::GR7::SetWeightNames(gri, {"other", "CV"});
+  NuHepMC::GR8::WriteProcessIDDefinitions(
+      gri, {{200, {"CCQE", "quasielastic"}}, {300, {"CCRES", "resonant"}}});
+  NuHepMC::GR9::WriteVertexStatusIDDefinitions(
+      gri, {{1, {"Primary", "primary vertex"}}});
+  NuHepMC::GR10::WriteParticleStatusIDDefinitions(
+      gri, {{1, {"UndecayedPhysical", "final state"}}});
+  NuHepMC::GC1::SetExposurePOT(gri, 1E20);
+  NuHepMC::add_attribute(gri, "NuHepMC.Citations.Generator.arXiv",
+                         std::string("1234.5678"));
+  NuHepMC::GC4::WriteBeamUnits(gri, "GEV", "");
+  NuHepMC::GC4::SetMonoEnergeticBeamType(gri);
+  NuHepMC::GC4::WriteBeamEnergyMonoenergetic(gri, 14, 1.5);
+
+  auto view = NuHepMC::MakeRunInfoView(gri);
+
+  REQUIRE(view->version == NuHepMC::GR2::ReadVersion(gri));
+
+  REQUIRE(view->signals("G.C.1"));
+  REQUIRE(view->signals(NuHepMC::ConventionBit("E.C.2")));
+  REQUIRE(view->signals("my.convention"));
+  REQUIRE(!view->signals("G.C.2"));
+  REQUIRE(!view->signals("other.convention"));
+  REQUIRE(!view->signals(-1));
+
+  REQUIRE(view->cross_section_units ==
+          NuHepMC::CrossSection::Units::cm2ten38_PerNucleon);
+  REQUIRE(view->cv_weight_index == 1);
+
+  REQUIRE(view->process_ids.descriptors() ==
+          NuHepMC::GR8::ReadProcessIdDefinitions(gri));
+  REQUIRE(view->process_ids.name(300) == "CCRES");
+  REQUIRE(view->vertex_status_ids.name(1) == "Primary");
+  REQUIRE(view->particle_status_ids.description(1) == "final state");
+  REQUIRE(view->nonstandard_particle_numbers.size() == 0);
+
+  REQUIRE(view->exposure_pot.value() == 1E20);
+  REQUIRE(!view->exposure_livetime);
+  REQUIRE(!view->fatx);
+
+  REQUIRE(view->citations == NuHepMC::GC3::ReadAllCitations(gri));
+  REQUIRE(view->energy_distributions.size() == 1);
+  REQUIRE(view->energy_distributions.at(14).MonoEnergeticEnergy == 1.5);
+
+  auto acc = NuHepMC::FATX::MakeAccumulator(*view);
+  REQUIRE(acc);
+  REQUIRE_THROWS_AS(NuHepMC::MakeRunInfoView(nullptr), NuHepMC::NullRunInfo);
+}
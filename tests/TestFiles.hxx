@@ -0,0 +1,91 @@
+#pragma once
+
+#include "NuHepMC/Constants.hxx"
+#include "NuHepMC/WriterUtils.hxx"
+
+#include "HepMC3/GenCrossSection.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+#include "HepMC3/WriterAscii.h"
+
+#include <string>
+
+// Writes a small NuHepMC file with nevents numu CC-like events on carbon,
+// numbered from 0. If fatx_convention is given, it is signalled and the
+// events carry what it needs: a running FATX estimate that changes from event
+// to event for E.C.4, and a total cross section that varies from event to
+// event for E.C.2.
+inline std::string WriteTestFile(std::string const &name, int nevents,
+                                 std::string const &fatx_convention = "") {
+  auto gri = std::make_shared<HepMC3::GenRunInfo>();
+  NuHepMC::GR2::WriteVersion(gri);
+  NuHepMC::GR7::SetWeightNames(gri, {"CV"});
+  if (fatx_convention.size()) {
+    NuHepMC::GR4::SetConventions(gri, {fatx_convention});
+    NuHepMC::GR6::SetCrossSectionUnits(gri, "pb", "PerAtom");
+  }
+
+  HepMC3::WriterAscii wrtr(name, gri);
+  for (int i = 0; i < nevents; ++i) {
+    HepMC3::GenEvent evt(gri, HepMC3::Units::MEV, HepMC3::Units::MM);
+    evt.set_event_number(i);
+    evt.weights() = {1};
+    if (fatx_convention == "E.C.4") {
+      auto xs = std::make_shared<HepMC3::GenCrossSection>();
+      xs->set_cross_section(1 + 1.0 / (i + 1), 0);
+      evt.set_cross_section(xs);
+    } else if (fatx_convention == "E.C.2") {
+      NuHepMC::EC2::SetTotalCrossSection(evt, 10 + 0.37 * (i % 11));
+    }
+
+    auto vtx = std::make_shared<HepMC3::GenVertex>();
+    vtx->set_status(NuHepMC::VertexStatus::Primary);
+    vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, 1000 + i, 1000 + i), 14,
+        NuHepMC::ParticleStatus::IncomingBeam));
+    vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, 0, 11178), 1000060120,
+        NuHepMC::ParticleStatus::Target));
+    vtx->add_particle_out(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, 900 + i, 900 + i), 13,
+        NuHepMC::ParticleStatus::UndecayedPhysical));
+    evt.add_vertex(vtx);
+
+    wrtr.write_event(evt);
+  }
+  wrtr.close();
+  return name;
+}
+
+// A primary vertex with a beam, a target, and a pile of final state particles
+// with repeated PDG codes and momenta, plus a secondary vertex
+inline HepMC3::GenEvent MakeBusyEvent() {
+  HepMC3::GenEvent evt(HepMC3::Units::MEV, HepMC3::Units::MM);
+
+  auto vtx = std::make_shared<HepMC3::GenVertex>();
+  vtx->set_status(NuHepMC::VertexStatus::Primary);
+  vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+      HepMC3::FourVector(0, 0, 1000, 1000), 14,
+      NuHepMC::ParticleStatus::IncomingBeam));
+  vtx->add_particle_in(std::make_shared<HepMC3::GenParticle>(
+      HepMC3::FourVector(0, 0, 0, 11178), 1000060120,
+      NuHepMC::ParticleStatus::Target));
+
+  int const pdgs[] = {13, 2212, 211, 2212, 111, 2112, 211, 2212, 22, 13};
+  double const pzs[] = {500, 300, 120, 450, 80, 450, 200, 10, 5, 320};
+  for (int i = 0; i < 10; ++i) {
+    vtx->add_particle_out(std::make_shared<HepMC3::GenParticle>(
+        HepMC3::FourVector(0, 0, pzs[i], pzs[i] + 1), pdgs[i],
+        NuHepMC::ParticleStatus::UndecayedPhysical));
+  }
+  evt.add_vertex(vtx);
+
+  auto vtx2 = std::make_shared<HepMC3::GenVertex>();
+  vtx2->set_status(NuHepMC::VertexStatus::FSISummary);
+  evt.add_vertex(vtx2);
+  vtx2->add_particle_out(std::make_shared<HepMC3::GenParticle>(
+      HepMC3::FourVector(0, 0, 700, 701), 2212,
+      NuHepMC::ParticleStatus::DecayedPhysical));
+
+  return evt;
+}